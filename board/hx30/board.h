@@ -198,11 +198,14 @@
 /* #define CONFIG_CHIPSET_SKYLAKE */
 /* #define CONFIG_CHIPSET_TIGERLAKE */
 #define CONFIG_CHIPSET_RESET_HOOK
+#define CONFIG_HOOK_SORTED_DISPATCH
 
 #define CONFIG_HOSTCMD_ESPI
 #define CONFIG_HOSTCMD_ESPI_VW_SLP_S3
 #define CONFIG_HOSTCMD_ESPI_VW_SLP_S4
 #define CONFIG_HOSTCMD_ESPI_VW_SLP_S5
+#define CONFIG_HOSTCMD_BATCH
+#define CONFIG_HOSTCMD_INPLACE
 
 #define CONFIG_POWER_S0IX
 #define CONFIG_POWER_TRACK_HOST_SLEEP_STATE
@@ -323,6 +326,13 @@
 /* TODO FRAMEWORK 
 #define CONFIG_VBOOT_HASH
 */
+/*
+ * Hash 4 KiB of SPI flash per deferred call.  Each window is read into one
+ * shared memory buffer, which saves the acquire and the WORK_INTERVAL_US
+ * wait between chunks, and still only holds the hook task for a few ms.
+ */
+#undef CONFIG_VBOOT_HASH_CHUNKS_PER_CALL
+#define CONFIG_VBOOT_HASH_CHUNKS_PER_CALL 4
 /*
  * MEC1701H loads firmware using QMSPI controller
  * CONFIG_SPI_FLASH_PORT is the index into
@@ -18,7 +18,7 @@
 #include "version.h"
 
 /* Large 768-Byte buffer for RSA computation : could be re-use afterwards... */
-static uint32_t rsa_workbuf[3 * RSANUMWORDS];
+static uint32_t rsa_workbuf[3 * RSANUMWORDS] __aligned(8);
 
 extern void pd_rx_handler(void);
 
@@ -36,34 +36,52 @@ static int flash_check_protect(int offset, int size)
 	return 0;
 }
 
-static void flash_set_persistent(void)
-{
-	FILE *f = get_persistent_storage("flash", "wb");
-	int sz;
-
-	ASSERT(f != NULL);
+/*
+ * Shared mapping of the persistent flash file. Writes and erases only copy
+ * and flush the erase blocks they touch instead of rewriting the whole image.
+ */
+static char *__host_flash_persist;
 
-	sz = fwrite(__host_flash, sizeof(__host_flash), 1, f);
-	ASSERT(sz == 1);
+static void flash_set_persistent(int offset, int size)
+{
+	int start = offset & ~(CONFIG_FLASH_ERASE_SIZE - 1);
+	int end = DIV_ROUND_UP(offset + size, CONFIG_FLASH_ERASE_SIZE) *
+		  CONFIG_FLASH_ERASE_SIZE;
 
-	release_persistent_storage(f);
+	memcpy(__host_flash_persist + start, __host_flash + start, end - start);
+	flush_persistent_storage(__host_flash_persist, start, end - start);
 }
 
 static void flash_get_persistent(void)
 {
-	FILE *f = get_persistent_storage("flash", "rb");
-
-	if (f == NULL) {
-		fprintf(stderr,
-			"No flash storage found. Initializing to 0xff.\n");
-		memset(__host_flash, 0xff, sizeof(__host_flash));
-		return;
+	int created;
+
+	if (__host_flash_persist == NULL) {
+		__host_flash_persist = map_persistent_storage(
+			"flash", sizeof(__host_flash), &created);
+		ASSERT(__host_flash_persist != NULL);
+
+		if (created) {
+			fprintf(stderr,
+				"No flash storage found. Initializing to 0xff.\n");
+			memset(__host_flash_persist, 0xff, sizeof(__host_flash));
+			flush_persistent_storage(__host_flash_persist, 0,
+						 sizeof(__host_flash));
+		}
 	}
 
-	fread(__host_flash, sizeof(__host_flash), 1, f);
+	memcpy(__host_flash, __host_flash_persist, sizeof(__host_flash));
+}
+
+#ifndef CONFIG_MAPPED_STORAGE
+/* Tests may treat the flash as not memory mapped, like SPI flash */
+int flash_physical_read(int offset, int size, char *data)
+{
+	memcpy(data, __host_flash + offset, size);
 
-	release_persistent_storage(f);
+	return EC_SUCCESS;
 }
+#endif
 
 int flash_physical_write(int offset, int size, const char *data)
 {
@@ -76,7 +94,7 @@ int flash_physical_write(int offset, int size, const char *data)
 		return EC_ERROR_ACCESS_DENIED;
 
 	memcpy(__host_flash + offset, data, size);
-	flash_set_persistent();
+	flash_set_persistent(offset, size);
 
 	return EC_SUCCESS;
 }
@@ -92,7 +110,7 @@ int flash_physical_erase(int offset, int size)
 		return EC_ERROR_ACCESS_DENIED;
 
 	memset(__host_flash + offset, 0xff, size);
-	flash_set_persistent();
+	flash_set_persistent(offset, size);
 
 	return EC_SUCCESS;
 }
@@ -120,6 +138,20 @@ int flash_physical_protect_now(int all)
 	return EC_SUCCESS;
 }
 
+#ifndef CONFIG_FLASH_PSTATE
+/*
+ * Without PSTATE the at-boot state belongs to the flash driver.  The
+ * emulator doesn't keep it across reboots, so apply it right away.
+ */
+int flash_physical_protect_at_boot(uint32_t new_flags)
+{
+	if (new_flags & EC_FLASH_PROTECT_RO_AT_BOOT)
+		return flash_physical_protect_now(0);
+
+	return EC_SUCCESS;
+}
+#endif
+
 uint32_t flash_physical_get_valid_flags(void)
 {
 	return EC_FLASH_PROTECT_RO_AT_BOOT |
@@ -14,4 +14,10 @@
 /* Get emulator executable name */
 const char *__get_prog_name(void);
 
+/*
+ * Get host monotonic wall-clock time in microseconds. Unlike get_time(), which
+ * is virtual in the emulator, this can be used to benchmark host code.
+ */
+uint64_t host_get_wall_time_us(void);
+
 #endif  /* __CROS_EC_HOST_TEST_H */
@@ -5,16 +5,29 @@
 
 /* Persistence module for emulator */
 
+#include <fcntl.h>
 #include <linux/limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/*
+ * If set, this is added to the storage names, so that several instances of
+ * the same executable (e.g. parallel test runs) do not share their state. It
+ * must be usable as part of a file name.
+ */
+#define PERSIST_NAMESPACE_ENV "EC_PERSIST_NAMESPACE"
+
 static void get_storage_path(char *out)
 {
 	char buf[PATH_MAX];
 	int sz;
 	char *current;
+	const char *ns = getenv(PERSIST_NAMESPACE_ENV);
 
 	sz = readlink("/proc/self/exe", buf, PATH_MAX - 1);
 	buf[sz] = '\0';
@@ -26,26 +39,79 @@ static void get_storage_path(char *out)
 		current = strchr(current, '/');
 	}
 
-	snprintf(out, PATH_MAX - 1, "/dev/shm/EC_persist_%s", buf);
+	if (ns && *ns)
+		snprintf(out, PATH_MAX - 1, "/dev/shm/EC_persist_%s_%s",
+			 ns, buf);
+	else
+		snprintf(out, PATH_MAX - 1, "/dev/shm/EC_persist_%s", buf);
 	out[PATH_MAX - 1] = '\0';
 }
 
-FILE *get_persistent_storage(const char *tag, const char *mode)
+static void get_tag_path(const char *tag, char *out)
 {
 	char buf[PATH_MAX];
-	char path[PATH_MAX];
 
 	/*
 	 * The persistent storage with tag 'foo' for test 'bar' would
 	 * be named 'bar_persist_foo'
 	 */
 	get_storage_path(buf);
-	snprintf(path, PATH_MAX - 1, "%s_%s", buf, tag);
-	path[PATH_MAX - 1] = '\0';
+	snprintf(out, PATH_MAX - 1, "%s_%s", buf, tag);
+	out[PATH_MAX - 1] = '\0';
+}
+
+FILE *get_persistent_storage(const char *tag, const char *mode)
+{
+	char path[PATH_MAX];
+
+	get_tag_path(tag, path);
 
 	return fopen(path, mode);
 }
 
+void *map_persistent_storage(const char *tag, size_t size, int *created)
+{
+	char path[PATH_MAX];
+	struct stat st;
+	void *map;
+	int fd;
+
+	get_tag_path(tag, path);
+
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	/* A missing or truncated backing file has no usable contents */
+	*created = (st.st_size != size);
+	if (*created && ftruncate(fd, size) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	/* The mapping holds its own reference to the file */
+	close(fd);
+
+	return map == MAP_FAILED ? NULL : map;
+}
+
+void flush_persistent_storage(void *map, size_t offset, size_t size)
+{
+	uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+	uintptr_t start = ((uintptr_t)map + offset) & ~page_mask;
+	uintptr_t end = (uintptr_t)map + offset + size;
+
+	/* Only the pages covering [offset, offset + size) are synced */
+	msync((void *)start, end - start, MS_SYNC);
+}
+
 void release_persistent_storage(FILE *ps)
 {
 	fclose(ps);
@@ -53,12 +119,9 @@ void release_persistent_storage(FILE *ps)
 
 void remove_persistent_storage(const char *tag)
 {
-	char buf[PATH_MAX];
 	char path[PATH_MAX];
 
-	get_storage_path(buf);
-	snprintf(path, PATH_MAX - 1, "%s_%s", buf, tag);
-	path[PATH_MAX - 1] = '\0';
+	get_tag_path(tag, path);
 
 	unlink(path);
 }
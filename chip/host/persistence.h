@@ -20,6 +20,27 @@ void release_persistent_storage(FILE *ps);
 
 void remove_persistent_storage(const char *tag);
 
+/**
+ * Map the persistent storage with the given tag into memory.
+ *
+ * The backing file is created (or resized) to size bytes if needed. Stores
+ * made through the returned mapping are shared with the backing file, so
+ * they survive an emulated reboot without rewriting the whole file.
+ *
+ * @param tag		Storage tag, as for get_persistent_storage()
+ * @param size		Size of the mapping in bytes
+ * @param created	Set to 1 if the backing file had no valid contents
+ * @return Pointer to the mapping, or NULL on failure.
+ */
+void *map_persistent_storage(const char *tag, size_t size, int *created);
+
+/**
+ * Synchronously flush a range of a mapping back to its backing file.
+ *
+ * Only the pages touched by [offset, offset + size) are synced.
+ */
+void flush_persistent_storage(void *map, size_t offset, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,7 +20,7 @@ void exit(int);
 
 #define SHARED_MEM_SIZE 0x2000 /* bytes */
 #define RAM_DATA_SIZE (sizeof(struct panic_data) + 512) /* bytes */
-uint8_t __shared_mem_buf[SHARED_MEM_SIZE + RAM_DATA_SIZE];
+uint8_t __shared_mem_buf[SHARED_MEM_SIZE + RAM_DATA_SIZE] __aligned(8);
 
 static char *__ram_data = __shared_mem_buf + SHARED_MEM_SIZE;
 
@@ -28,6 +28,10 @@ static pthread_t input_thread;
 #define INPUT_BUFFER_SIZE 16
 static int char_available;
 
+/*
+ * Filled by the stdin monitor thread (or a test injecting input) and drained
+ * by the UART interrupt, so it uses the queue_spsc_* functions.
+ */
 static struct queue const cached_char = QUEUE_NULL(INPUT_BUFFER_SIZE, char);
 
 #define CONSOLE_CAPTURE_SIZE 2048
@@ -115,7 +119,7 @@ int uart_read_char(void)
 {
 	char ret;
 	ASSERT(in_interrupt_context());
-	queue_remove_unit(&cached_char, &ret);
+	queue_spsc_remove_unit(&cached_char, &ret);
 	--char_available;
 	return ret;
 }
@@ -129,7 +133,7 @@ void uart_inject_char(char *s, int sz)
 		num_char = MIN(INPUT_BUFFER_SIZE - 1, sz - i);
 		if (queue_space(&cached_char) < num_char)
 			return;
-		queue_add_units(&cached_char, s + i, num_char);
+		queue_spsc_add_units(&cached_char, s + i, num_char);
 		char_available = num_char;
 		task_trigger_test_interrupt(uart_interrupt);
 	}
@@ -164,7 +168,7 @@ void *uart_monitor_stdin(void *d)
 		tcsetattr(0, TCSANOW, &new_settings);
 		rv = read(0, buf, INPUT_BUFFER_SIZE);
 		if (queue_space(&cached_char) >= rv) {
-			queue_add_units(&cached_char, buf, rv);
+			queue_spsc_add_units(&cached_char, buf, rv);
 			char_available = rv;
 		}
 		tcsetattr(0, TCSANOW, &org_settings);
@@ -33,6 +33,21 @@ static inline void crc32_hash16(uint16_t val)
 	STM32_CRC_DR16 = val;
 }
 
+static inline void crc32_hash(const void *buf, int size)
+{
+	const uint8_t *p = buf;
+
+	/* Feed whole aligned words to the engine, bytes at the edges */
+	for (; size && ((uintptr_t)p & 3); size--)
+		STM32_CRC_DR8 = *p++;
+
+	for (; size >= 4; size -= 4, p += 4)
+		STM32_CRC_DR = *(const uint32_t *)p;
+
+	while (size--)
+		STM32_CRC_DR8 = *p++;
+}
+
 static inline uint32_t crc32_result(void)
 {
 	return STM32_CRC_DR ^ 0xFFFFFFFF;
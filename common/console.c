@@ -126,26 +126,39 @@ static int split_words(char *input, int *argc, char **argv)
  *
  * @return A pointer to the command structure, or NULL if no match found.
  */
-static const struct console_command *find_command(char *name)
+test_export_static const struct console_command *find_command(
+	const char *name)
 {
-	const struct console_command *cmd, *match = NULL;
+	const struct console_command *lo = __cmds, *hi = __cmds_end, *mid;
 	int match_length = strlen(name);
 
-	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
-		if (!strncasecmp(name, cmd->name, match_length)) {
-			if (match)
-				return NULL;
-			/*
-			 * Check if 'cmd->name' is of the same length as
-			 * 'name'. If yes, then we have a full match.
-			 */
-			if (cmd->name[match_length] == '\0')
-				return cmd;
-			match = cmd;
-		}
+	/*
+	 * The linker scripts SORT() the command section by name, so binary
+	 * search for the first command not less than 'name'. All commands
+	 * 'name' is a prefix of follow it contiguously, and a full match sorts
+	 * first among them.
+	 */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (strcasecmp(mid->name, name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	return match;
+	if (lo == __cmds_end || strncasecmp(name, lo->name, match_length))
+		return NULL;
+
+	/* Full match */
+	if (lo->name[match_length] == '\0')
+		return lo;
+
+	/* Partial match; ambiguous if the next command matches too */
+	if (lo + 1 < __cmds_end &&
+	    !strncasecmp(name, lo[1].name, match_length))
+		return NULL;
+
+	return lo;
 }
 
 
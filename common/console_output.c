@@ -107,6 +107,26 @@ int cprints(enum console_channel channel, const char *format, ...)
 	return r ? r : rv;
 }
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+int cprints_tokenized(enum console_channel channel, const char *format, ...)
+{
+	int rv;
+	va_list args;
+
+#ifdef CONFIG_CONSOLE_CHANNEL
+	/* Filter out inactive channels */
+	if (!(CC_MASK(channel) & channel_mask))
+		return EC_SUCCESS;
+#endif
+
+	va_start(args, format);
+	rv = uart_log_tokens(channel, format, args);
+	va_end(args);
+
+	return rv;
+}
+#endif
+
 void cflush(void)
 {
 	uart_flush_output();
@@ -14,7 +14,7 @@
 
 #ifdef CONFIG_HOOK_DEBUG
 #define CPUTS(outstr) cputs(CC_HOOK, outstr)
-#define CPRINTS(format, args...) cprints(CC_HOOK, format, ## args)
+#define CPRINTS(format, args...) cprints_tok(CC_HOOK, format, ## args)
 #else
 #define CPUTS(outstr)
 #define CPRINTS(format, args...)
@@ -22,6 +22,25 @@
 
 #define DEFERRED_FUNCS_COUNT (__deferred_funcs_end - __deferred_funcs)
 
+/*
+ * Deferred call queue, laid out in the linker-reserved __deferred_queue:
+ *
+ * - deferred_pending: bitmap of deferred funcs whose firing time changed
+ *   since the hook task last looked at them.
+ * - deferred_heap: min-heap of queued deferred funcs, ordered by firing
+ *   time in __deferred_until[].
+ * - deferred_slot: heap slot of each deferred func, plus one, or 0 if the
+ *   func is not queued.
+ *
+ * hook_call_deferred() may be called from any task or interrupt, so it only
+ * updates __deferred_until[] and sets the pending bit.  The heap is owned by
+ * the hook task, which folds pending funcs into it before using it.
+ */
+#define DEFERRED_PENDING_WORDS DIV_ROUND_UP(DEFERRED_FUNCS_COUNT, 32)
+#define deferred_pending (__deferred_queue)
+#define deferred_heap ((uint16_t *)(__deferred_queue + DEFERRED_PENDING_WORDS))
+#define deferred_slot (deferred_heap + DEFERRED_FUNCS_COUNT)
+
 struct hook_ptrs {
 	const struct hook_data *start;
 	const struct hook_data *end;
@@ -65,9 +84,15 @@ static const struct hook_ptrs hook_list[] = {
 };
 
 /* Times for deferrable functions */
-static int defer_new_call;
+static volatile int defer_new_call;
 static int hook_task_started;
 
+/* Time the hook task will next wake up on its own, if it is asleep */
+static volatile uint64_t hook_wake_time = -1;
+
+/* Number of deferred funcs in deferred_heap */
+static int deferred_queue_len;
+
 #ifdef CONFIG_HOOK_DEBUG
 /* Stats for hooks */
 static uint64_t max_hook_tick_delay;
@@ -78,6 +103,11 @@ static uint64_t avg_hook_tick_delay;
 static uint64_t avg_hook_second_delay;
 static uint64_t avg_hook_run_time[ARRAY_SIZE(hook_list)];
 
+/* Stats for deferred calls */
+static uint64_t max_deferred_delay;
+static uint64_t avg_deferred_delay;
+static int max_deferred_queue_len;
+
 static inline void update_hook_average(uint64_t *avg, uint64_t time)
 {
 	*avg = (*avg * 7 + time) >> 3;
@@ -100,13 +130,74 @@ static void record_hook_delay(uint64_t now, uint64_t last, uint64_t interval,
 		CPRINTS("Hook at interval %d us delayed by %d us",
 			(uint32_t)interval, (uint32_t)delayed);
 }
+
+static void record_deferred_delay(uint64_t until)
+{
+	uint64_t delayed = get_time().val - until;
+
+	if (delayed > max_deferred_delay)
+		max_deferred_delay = delayed;
+	update_hook_average(&avg_deferred_delay, delayed);
+}
+#endif
+
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+/*
+ * Start of each hook type's slice of __hooks_sorted, plus one entry marking
+ * the end of the last slice.  Filled in by sort_hooks().
+ */
+test_export_static const struct hook_data **
+	sorted_hooks[ARRAY_SIZE(hook_list) + 1];
+
+/*
+ * The linker script sizes __hooks_sorted at half the size of the hook
+ * tables, which only holds if a hook_data is exactly two pointers wide.
+ */
+BUILD_ASSERT(sizeof(struct hook_data) == 2 * sizeof(struct hook_data *));
+
+/**
+ * Sort every hook table by priority into __hooks_sorted.
+ *
+ * Uses an insertion sort, which is stable, so hooks of equal priority are
+ * still called in link order as with the unsorted dispatch.
+ */
+static void sort_hooks(void)
+{
+	const struct hook_data **out = __hooks_sorted;
+	const struct hook_data **slot;
+	const struct hook_data *p;
+	int type;
+
+	for (type = 0; type < ARRAY_SIZE(hook_list); type++) {
+		sorted_hooks[type] = out;
+
+		for (p = hook_list[type].start; p < hook_list[type].end; p++) {
+			for (slot = out++; slot > sorted_hooks[type] &&
+			     slot[-1]->priority > p->priority; slot--)
+				slot[0] = slot[-1];
+			*slot = p;
+		}
+	}
+	sorted_hooks[type] = out;
+}
+#endif
+
+void hook_pre_init(void)
+{
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+	sort_hooks();
 #endif
+}
 
 void hook_notify(enum hook_type type)
 {
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+	const struct hook_data **p;
+#else
 	const struct hook_data *start, *end, *p;
 	int count, called = 0;
 	int last_prio = HOOK_PRIO_FIRST - 1, prio;
+#endif
 #ifdef CONFIG_HOOK_DEBUG
 	uint64_t start_time = get_time().val;
 	uint64_t run_time;
@@ -114,6 +205,11 @@ void hook_notify(enum hook_type type)
 
 	CPRINTS("hook notify %d", type);
 
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+	/* Hooks are already in priority order */
+	for (p = sorted_hooks[type]; p < sorted_hooks[type + 1]; p++)
+		(*p)->routine();
+#else
 	start = hook_list[type].start;
 	end = hook_list[type].end;
 	count = end - start;
@@ -135,6 +231,7 @@ void hook_notify(enum hook_type type)
 			}
 		}
 	}
+#endif
 
 #ifdef CONFIG_HOOK_DEBUG
 	run_time = get_time().val - start_time;
@@ -144,6 +241,112 @@ void hook_notify(enum hook_type type)
 #endif
 }
 
+/*****************************************************************************/
+/* Deferred call queue, only touched by the hook task */
+
+static void deferred_heap_set(int slot, int i)
+{
+	deferred_heap[slot] = i;
+	deferred_slot[i] = slot + 1;
+}
+
+static void deferred_heap_sift_up(int slot)
+{
+	int i = deferred_heap[slot];
+	int parent;
+
+	while (slot > 0) {
+		parent = (slot - 1) / 2;
+		if (__deferred_until[deferred_heap[parent]] <=
+		    __deferred_until[i])
+			break;
+		deferred_heap_set(slot, deferred_heap[parent]);
+		slot = parent;
+	}
+	deferred_heap_set(slot, i);
+}
+
+static void deferred_heap_sift_down(int slot)
+{
+	int i = deferred_heap[slot];
+	int child;
+
+	while ((child = 2 * slot + 1) < deferred_queue_len) {
+		if (child + 1 < deferred_queue_len &&
+		    __deferred_until[deferred_heap[child + 1]] <
+		    __deferred_until[deferred_heap[child]])
+			child++;
+		if (__deferred_until[i] <=
+		    __deferred_until[deferred_heap[child]])
+			break;
+		deferred_heap_set(slot, deferred_heap[child]);
+		slot = child;
+	}
+	deferred_heap_set(slot, i);
+}
+
+static void deferred_queue_remove(int i)
+{
+	int slot = deferred_slot[i] - 1;
+	int last;
+
+	if (slot < 0)
+		return;
+
+	deferred_slot[i] = 0;
+	if (slot == --deferred_queue_len)
+		return;
+
+	/* Move the last func into the hole and restore heap order */
+	last = deferred_heap[deferred_queue_len];
+	deferred_heap_set(slot, last);
+	deferred_heap_sift_up(slot);
+	deferred_heap_sift_down(deferred_slot[last] - 1);
+}
+
+static void deferred_queue_update(int i)
+{
+	int slot = deferred_slot[i] - 1;
+
+	if (!__deferred_until[i]) {
+		deferred_queue_remove(i);
+		return;
+	}
+
+	if (slot < 0) {
+		slot = deferred_queue_len++;
+		deferred_heap_set(slot, i);
+#ifdef CONFIG_HOOK_DEBUG
+		if (deferred_queue_len > max_deferred_queue_len)
+			max_deferred_queue_len = deferred_queue_len;
+#endif
+	}
+
+	deferred_heap_sift_up(slot);
+	deferred_heap_sift_down(deferred_slot[i] - 1);
+}
+
+/**
+ * Fold deferred funcs whose firing time changed into the heap.
+ */
+static void deferred_queue_sync(void)
+{
+	uint32_t pending;
+	int w;
+
+	for (w = 0; w < DEFERRED_PENDING_WORDS; w++) {
+		pending = deprecated_atomic_read_clear(deferred_pending + w);
+		while (pending) {
+			int bit = __fls(pending);
+
+			pending &= ~BIT(bit);
+			deferred_queue_update(w * 32 + bit);
+		}
+	}
+}
+
+/*****************************************************************************/
+
 int hook_call_deferred(const struct deferred_data *data, int us)
 {
 	int i = data - __deferred_funcs;
@@ -154,9 +357,12 @@ int hook_call_deferred(const struct deferred_data *data, int us)
 	if (us == -1) {
 		/* Cancel */
 		__deferred_until[i] = 0;
+		deprecated_atomic_or(deferred_pending + i / 32, BIT(i % 32));
 	} else {
 		/* Set alarm */
 		__deferred_until[i] = get_time().val + us;
+		deprecated_atomic_or(deferred_pending + i / 32, BIT(i % 32));
+
 		/*
 		 * Flag that hook_call_deferred() has been called.  If the hook
 		 * task is already active, this will allow it to go through the
@@ -164,8 +370,11 @@ int hook_call_deferred(const struct deferred_data *data, int us)
 		 */
 		defer_new_call = 1;
 
-		/* Wake task so it can re-sleep for the proper time */
-		if (hook_task_started)
+		/*
+		 * Wake task so it can re-sleep for the proper time, unless it
+		 * is already due to wake up before this routine.
+		 */
+		if (hook_task_started && __deferred_until[i] < hook_wake_time)
 			task_wake(TASK_ID_HOOKS);
 	}
 
@@ -191,18 +400,33 @@ void hook_task(void *u)
 		int next = 0;
 		int i;
 
-		/* Handle deferred routines */
-		for (i = 0; i < DEFERRED_FUNCS_COUNT; i++) {
-			if (__deferred_until[i] && __deferred_until[i] < t) {
-				CPRINTS("hook call deferred 0x%pP",
-					__deferred_funcs[i].routine);
-				/*
-				 * Call deferred function.  Clear timer first,
-				 * so it can request itself be called later.
-				 */
-				__deferred_until[i] = 0;
-				__deferred_funcs[i].routine();
+		/* Don't skip wake-ups while we are running */
+		hook_wake_time = -1;
+
+		/* Handle deferred routines, earliest first */
+		deferred_queue_sync();
+		while (deferred_queue_len) {
+			i = deferred_heap[0];
+			if (!__deferred_until[i]) {
+				/* Cancelled since the last sync */
+				deferred_queue_remove(i);
+				continue;
 			}
+			if (__deferred_until[i] >= t)
+				break;
+
+			CPRINTS("hook call deferred 0x%pP",
+				__deferred_funcs[i].routine);
+#ifdef CONFIG_HOOK_DEBUG
+			record_deferred_delay(__deferred_until[i]);
+#endif
+			/*
+			 * Call deferred function.  Clear timer first,
+			 * so it can request itself be called later.
+			 */
+			__deferred_until[i] = 0;
+			deferred_queue_remove(i);
+			__deferred_funcs[i].routine();
 		}
 
 		if (t - last_tick >= HOOK_TICK_INTERVAL) {
@@ -232,11 +456,10 @@ void hook_task(void *u)
 
 		/* Wake earlier if needed by a deferred routine */
 		defer_new_call = 0;
+		deferred_queue_sync();
 
-		for (i = 0; i < DEFERRED_FUNCS_COUNT && next > 0; i++) {
-			if (!__deferred_until[i])
-				continue;
-
+		if (deferred_queue_len && next > 0) {
+			i = deferred_heap[0];
 			if (__deferred_until[i] < t)
 				next = 0;
 			else if (__deferred_until[i] - t < next)
@@ -248,6 +471,7 @@ void hook_task(void *u)
 		 * hasn't been called since we started calculating next, sleep
 		 * until the next event.
 		 */
+		hook_wake_time = t + next;
 		if (next > 0 && !defer_new_call)
 			task_wait_event(next);
 	}
@@ -278,6 +502,12 @@ static int command_stats(int argc, char **argv)
 	ccprintf("HOOK_SECOND:\n");
 	print_hook_delay(SECOND, max_hook_second_delay, avg_hook_second_delay);
 
+	ccprintf("Deferred calls:\n");
+	ccprintf("  Max delayed: %7d us\n", (uint32_t)max_deferred_delay);
+	ccprintf("  Average:     %7d us\n", (uint32_t)avg_deferred_delay);
+	ccprintf("  Max queued:  %7d / %d\n\n", max_deferred_queue_len,
+		 (int)DEFERRED_FUNCS_COUNT);
+
 	ccprintf("Max run time for each hook:\n");
 	for (i = 0; i < ARRAY_SIZE(hook_list); ++i)
 		ccprintf("%3d:%6d us (Avg: %5d us)\n", i,
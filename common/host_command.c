@@ -77,6 +77,8 @@ static struct host_cmd_handler_args args0;
 /* Current host command packet from host, for protocol version 3+ */
 static struct host_packet *pkt0;
 
+static const struct host_command *find_host_command(int command);
+
 /*
  * Host command suppress
  */
@@ -204,12 +206,56 @@ void host_command_received(struct host_cmd_handler_args *args)
 	host_send_response(args);
 }
 
+/**
+ * Add the bytes of a buffer to a checksum.
+ *
+ * Works a word at a time: the bytes of each word are summed in 16-bit lanes,
+ * which cannot overflow within 256 words.
+ */
+static uint32_t checksum_add(uint32_t csum, const uint8_t *p, int size)
+{
+	while (size > 0 && ((uintptr_t)p & 3)) {
+		csum += *p++;
+		size--;
+	}
+
+	while (size >= 4) {
+		int n = MIN(size / 4, 256);
+		uint32_t even = 0, odd = 0;
+
+		size -= n * 4;
+		for (; n > 0; n--, p += 4) {
+			uint32_t w = *(const uint32_t *)p;
+
+			even += w & 0x00ff00ff;
+			odd += (w >> 8) & 0x00ff00ff;
+		}
+		csum += (even & 0xffff) + (even >> 16) +
+			(odd & 0xffff) + (odd >> 16);
+	}
+
+	while (size-- > 0)
+		csum += *p++;
+
+	return csum;
+}
+
+/* Return non-zero if the params of the command can be read in place */
+static int host_command_params_in_place(int command)
+{
+#ifdef CONFIG_HOSTCMD_INPLACE
+	const struct host_command *cmd = find_host_command(command);
+
+	return cmd && (cmd->flags & HOST_CMD_FLAG_INPLACE);
+#else
+	return 0;
+#endif
+}
+
 void host_packet_respond(struct host_cmd_handler_args *args)
 {
 	struct ec_host_response *r = (struct ec_host_response *)pkt0->response;
-	uint8_t *out = (uint8_t *)pkt0->response;
-	int csum = 0;
-	int i;
+	uint32_t csum;
 
 	/* Clip result size to what we can accept */
 	if (args->result) {
@@ -228,13 +274,9 @@ void host_packet_respond(struct host_cmd_handler_args *args)
 	r->data_len = args->response_size;
 	r->reserved = 0;
 
-	/* Start checksum; this also advances *out to end of response */
-	for (i = sizeof(*r); i > 0; i--)
-		csum += *out++;
-
-	/* Checksum response data, if any */
-	for (i = args->response_size; i > 0; i--)
-		csum += *out++;
+	/* Checksum response header and data, if any */
+	csum = checksum_add(0, (const uint8_t *)r,
+			    sizeof(*r) + args->response_size);
 
 	/* Write checksum field so the entire packet sums to 0 */
 	r->checksum = (uint8_t)(-csum);
@@ -263,8 +305,7 @@ void host_packet_receive(struct host_packet *pkt)
 		(const struct ec_host_request *)pkt->request;
 	const uint8_t *in = (const uint8_t *)pkt->request;
 	uint8_t *itmp = (uint8_t *)pkt->request_temp;
-	int csum = 0;
-	int i;
+	uint32_t csum;
 
 	/* Track the packet we're handling */
 	pkt0 = pkt;
@@ -295,17 +336,16 @@ void host_packet_receive(struct host_packet *pkt)
 
 	/* Start checksum and copy request header if necessary */
 	if (pkt->request_temp) {
-		/* Copy to temp buffer and checksum */
-		for (i = sizeof(*r); i > 0; i--) {
-			*itmp = *in++;
-			csum += *itmp++;
-		}
+		/* Copy to temp buffer and checksum the copy */
+		memcpy(itmp, in, sizeof(*r));
+		csum = checksum_add(0, itmp, sizeof(*r));
 		r = (const struct ec_host_request *)pkt->request_temp;
+		itmp += sizeof(*r);
 	} else {
 		/* Just checksum */
-		for (i = sizeof(*r); i > 0; i--)
-			csum += *in++;
+		csum = checksum_add(0, in, sizeof(*r));
 	}
+	in += sizeof(*r);
 
 	if (r->struct_version != EC_HOST_REQUEST_VERSION) {
 		/* Request header we don't know how to handle */
@@ -325,22 +365,19 @@ void host_packet_receive(struct host_packet *pkt)
 	}
 
 	/* Copy request data and validate checksum */
-	if (pkt->request_temp) {
+	if (pkt->request_temp && !host_command_params_in_place(r->command)) {
 		/* Params go in temporary buffer */
 		args0.params = itmp;
 
-		/* Copy request data and checksum */
-		for (i = r->data_len; i > 0; i--) {
-			*itmp = *in++;
-			csum += *itmp++;
-		}
+		/* Copy request data and checksum the copy */
+		memcpy(itmp, in, r->data_len);
+		csum = checksum_add(csum, itmp, r->data_len);
 	} else {
 		/* Params read directly from request */
 		args0.params = in;
 
 		/* Just checksum */
-		for (i = r->data_len; i > 0; i--)
-			csum += *in++;
+		csum = checksum_add(csum, in, r->data_len);
 	}
 
 	/* Validate checksum */
@@ -501,9 +538,9 @@ static enum ec_status host_command_hello(struct host_cmd_handler_args *args)
 
 	return EC_RES_SUCCESS;
 }
-DECLARE_HOST_COMMAND(EC_CMD_HELLO,
-		     host_command_hello,
-		     EC_VER_MASK(0));
+DECLARE_HOST_COMMAND_INPLACE(EC_CMD_HELLO,
+			     host_command_hello,
+			     EC_VER_MASK(0));
 
 static enum ec_status host_command_read_test(struct host_cmd_handler_args *args)
 {
@@ -556,9 +593,9 @@ host_command_read_memmap(struct host_cmd_handler_args *args)
 
 	return EC_RES_SUCCESS;
 }
-DECLARE_HOST_COMMAND(EC_CMD_READ_MEMMAP,
-		     host_command_read_memmap,
-		     EC_VER_MASK(0));
+DECLARE_HOST_COMMAND_INPLACE(EC_CMD_READ_MEMMAP,
+			     host_command_read_memmap,
+			     EC_VER_MASK(0));
 #endif
 
 static enum ec_status
@@ -581,9 +618,9 @@ host_command_get_cmd_versions(struct host_cmd_handler_args *args)
 
 	return EC_RES_SUCCESS;
 }
-DECLARE_HOST_COMMAND(EC_CMD_GET_CMD_VERSIONS,
-		     host_command_get_cmd_versions,
-		     EC_VER_MASK(0) | EC_VER_MASK(1));
+DECLARE_HOST_COMMAND_INPLACE(EC_CMD_GET_CMD_VERSIONS,
+			     host_command_get_cmd_versions,
+			     EC_VER_MASK(0) | EC_VER_MASK(1));
 
 static int host_command_is_suppressed(uint16_t cmd)
 {
@@ -680,13 +717,169 @@ static void host_command_debug_request(struct host_cmd_handler_args *args)
 		CPRINTS("HC 0x%02x", args->command);
 }
 
-uint16_t host_command_process(struct host_cmd_handler_args *args)
+#ifdef CONFIG_HOSTCMD_STATS
+/*
+ * Host command latency statistics
+ */
+struct hostcmd_stats {
+	uint16_t command;
+	uint32_t count;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint16_t histogram[EC_HOSTCMD_STATS_BUCKETS];
+};
+
+BUILD_ASSERT(CONFIG_HOSTCMD_STATS_COUNT <= UINT8_MAX);
+
+static struct hostcmd_stats hc_stats[CONFIG_HOSTCMD_STATS_COUNT];
+static int hc_stats_used;
+/* Serializes the HOSTCMD task's updates with console reads and resets */
+static struct mutex hc_stats_lock;
+
+static void hostcmd_stats_record(uint16_t command, uint64_t elapsed)
+{
+	struct hostcmd_stats *s;
+	uint32_t us = MIN(elapsed, UINT32_MAX);
+	int i;
+
+	/* Don't let reading the stats skew them */
+	if (command == EC_CMD_HOSTCMD_STATS)
+		return;
+
+	/*
+	 * GET_COMMS_STATUS may be answered straight from the LPC interrupt,
+	 * where the table lock can't be taken; leave those out.
+	 */
+	if (in_interrupt_context())
+		return;
+
+	mutex_lock(&hc_stats_lock);
+	for (i = 0; i < hc_stats_used; i++)
+		if (hc_stats[i].command == command)
+			break;
+
+	if (i == hc_stats_used) {
+		if (i == ARRAY_SIZE(hc_stats)) {
+			mutex_unlock(&hc_stats_lock);
+			return;
+		}
+		hc_stats_used++;
+		s = &hc_stats[i];
+		s->command = command;
+		s->min_us = UINT32_MAX;
+	} else {
+		s = &hc_stats[i];
+	}
+
+	s->count++;
+	s->total_us += us;
+	s->min_us = MIN(s->min_us, us);
+	s->max_us = MAX(s->max_us, us);
+
+	i = us > 1 ? __fls(us) : 0;
+	i = MIN(i, EC_HOSTCMD_STATS_BUCKETS - 1);
+	if (s->histogram[i] != UINT16_MAX)
+		s->histogram[i]++;
+	mutex_unlock(&hc_stats_lock);
+}
+
+static void hostcmd_stats_reset(void)
+{
+	mutex_lock(&hc_stats_lock);
+	memset(hc_stats, 0, sizeof(hc_stats));
+	hc_stats_used = 0;
+	mutex_unlock(&hc_stats_lock);
+}
+
+static enum ec_status
+host_command_hostcmd_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_hostcmd_stats *p = args->params;
+	struct ec_response_hostcmd_stats *r = args->response;
+	const struct hostcmd_stats *s;
+
+	memset(r, 0, sizeof(*r));
+	mutex_lock(&hc_stats_lock);
+	r->num_entries = hc_stats_used;
+	if (p->index < hc_stats_used) {
+		s = &hc_stats[p->index];
+		r->command = s->command;
+		r->count = s->count;
+		r->min_us = s->min_us;
+		r->max_us = s->max_us;
+		r->avg_us = s->total_us / s->count;
+		memcpy(r->histogram, s->histogram, sizeof(r->histogram));
+	}
+	mutex_unlock(&hc_stats_lock);
+	args->response_size = sizeof(*r);
+
+	if (p->flags & EC_HOSTCMD_STATS_RESET)
+		hostcmd_stats_reset();
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_HOSTCMD_STATS,
+		     host_command_hostcmd_stats,
+		     EC_VER_MASK(0));
+
+static int command_hcstats(int argc, char **argv)
+{
+	struct hostcmd_stats copy;
+	const struct hostcmd_stats *s = &copy;
+	int i, b, more;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		hostcmd_stats_reset();
+		return EC_SUCCESS;
+	}
+
+	ccprintf("cmd     count     min     avg     max (us)\n");
+	for (i = 0; ; i++) {
+		/* Print from a snapshot so the HOSTCMD task isn't held up */
+		mutex_lock(&hc_stats_lock);
+		more = i < hc_stats_used;
+		if (more)
+			copy = hc_stats[i];
+		mutex_unlock(&hc_stats_lock);
+		if (!more)
+			break;
+		ccprintf("0x%04x %6d %7d %7d %7d\n", s->command, s->count,
+			 s->min_us, (uint32_t)(s->total_us / s->count),
+			 s->max_us);
+		/* Non-empty buckets, labelled with their lower bound */
+		ccputs("      ");
+		for (b = 0; b < EC_HOSTCMD_STATS_BUCKETS; b++)
+			if (s->histogram[b])
+				ccprintf(" %d:%d", b ? 1 << b : 0,
+					 s->histogram[b]);
+		ccputs("\n");
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(hcstats, command_hcstats,
+			"[reset]",
+			"Print or reset host command latency statistics");
+#endif /* CONFIG_HOSTCMD_STATS */
+
+/**
+ * Run a host command, without printing the request for hcdebug.
+ *
+ * @param args		Host command args
+ * @return resulting status
+ */
+static uint16_t host_command_run(struct host_cmd_handler_args *args)
 {
 	const struct host_command *cmd;
+	int known __maybe_unused = 1;
 	int rv;
-
-	if (hcdebug)
-		host_command_debug_request(args);
+#ifdef CONFIG_HOSTCMD_STATS
+	timestamp_t t0 = get_time();
+#endif
 
 	/*
 	 * Pre-emptively clear the entire response buffer so we do not
@@ -698,9 +891,15 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 	 * Note that if request and response buffers pointed to the same memory
 	 * location, then the chip implementation already needed to provide a
 	 * request_temp buffer in which the request data was already copied
-	 * by this point (see host_packet_receive function).
+	 * by this point (see host_packet_receive function), unless the command
+	 * reads its params in place: those must be kept.
 	 */
-	memset(args->response, 0, args->response_max);
+	if (args->params == args->response &&
+	    args->params_size < args->response_max)
+		memset((uint8_t *)args->response + args->params_size, 0,
+		       args->response_max - args->params_size);
+	else if (args->params != args->response)
+		memset(args->response, 0, args->response_max);
 
 #ifdef CONFIG_HOSTCMD_PD
 	if (args->command >= EC_CMD_PASSTHRU_OFFSET(1) &&
@@ -721,14 +920,21 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 #endif
 	{
 		cmd = find_host_command(args->command);
-		if (!cmd)
+		if (!cmd) {
 			rv = EC_RES_INVALID_COMMAND;
-		else if (!(EC_VER_MASK(args->version) & cmd->version_mask))
+			known = 0;
+		} else if (!(EC_VER_MASK(args->version) & cmd->version_mask))
 			rv = EC_RES_INVALID_VERSION;
 		else
 			rv = cmd->handler(args);
 	}
 
+#ifdef CONFIG_HOSTCMD_STATS
+	/* Unknown commands would only use up slots meant for real ones */
+	if (known)
+		hostcmd_stats_record(args->command, get_time().val - t0.val);
+#endif
+
 	if (rv != EC_RES_SUCCESS)
 		CPRINTS("HC 0x%02x err %d", args->command, rv);
 
@@ -739,6 +945,14 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 	return rv;
 }
 
+uint16_t host_command_process(struct host_cmd_handler_args *args)
+{
+	if (hcdebug)
+		host_command_debug_request(args);
+
+	return host_command_run(args);
+}
+
 #ifdef CONFIG_HOST_COMMAND_STATUS
 /* Returns current command status (busy or not) */
 static enum ec_status
@@ -760,13 +974,17 @@ DECLARE_HOST_COMMAND(EC_CMD_GET_COMMS_STATUS,
 static enum ec_status
 host_command_resend_response(struct host_cmd_handler_args *args)
 {
-	/* Handle resending response */
-	args->result = saved_result;
+	enum ec_status rv = saved_result;
+
+	/*
+	 * Handle resending response.  The host command task sets the result
+	 * from our return value, so return the saved result.
+	 */
 	args->response_size = 0;
 
 	saved_result = EC_RES_UNAVAILABLE;
 
-	return EC_RES_SUCCESS;
+	return rv;
 }
 
 DECLARE_HOST_COMMAND(EC_CMD_RESEND_RESPONSE,
@@ -808,6 +1026,100 @@ DECLARE_HOST_COMMAND(EC_CMD_GET_FEATURES,
 		     host_command_get_features,
 		     EC_VER_MASK(0));
 
+#ifdef CONFIG_HOSTCMD_BATCH
+/**
+ * Check whether a command may run inside a batch.
+ *
+ * Commands which call host_send_response() before they are done (to tell the
+ * host they are in progress, or to clear its busy bits before a reboot)
+ * can't be batched: the batch only responds once all its sub-commands ran.
+ */
+static int host_command_batchable(uint16_t command)
+{
+	switch (command) {
+	case EC_CMD_BATCH:
+	case EC_CMD_REBOOT_EC:
+	case EC_CMD_FLASH_ERASE:
+		return 0;
+	default:
+		return 1;
+	}
+}
+
+static void host_command_batch_send_response(struct host_cmd_handler_args *args)
+{
+	/* Sub-commands which respond early are refused; nothing to send. */
+}
+
+/* Runs the sub-commands of a batch, each like host_command_process(). */
+static enum ec_status host_command_batch(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_batch *p = args->params;
+	struct ec_response_batch *r = args->response;
+	const uint8_t *in = (const uint8_t *)(p + 1);
+	const uint8_t *in_end = (const uint8_t *)args->params +
+				args->params_size;
+	uint8_t *out = (uint8_t *)(r + 1);
+	uint8_t *out_end = (uint8_t *)args->response + args->response_max;
+	struct host_cmd_handler_args sub;
+	int i;
+
+	/* Sub-command responses would overwrite the params still to run */
+	if (args->params == args->response ||
+	    args->params_size < sizeof(*p))
+		return EC_RES_INVALID_PARAM;
+
+	for (i = 0; i < p->num_cmds; i++) {
+		const struct ec_batch_request *req = (const void *)in;
+		struct ec_batch_response *resp = (void *)out;
+		int in_left = in_end - in;
+		int out_left = out_end - out;
+
+		if (in_left < (int)sizeof(*req) ||
+		    in_left - (int)sizeof(*req) < req->params_size)
+			return EC_RES_INVALID_PARAM;
+		if (out_left < (int)sizeof(*resp) +
+			       EC_BATCH_ALIGN(req->response_max))
+			break;
+
+		memset(&sub, 0, sizeof(sub));
+		sub.command = req->command;
+		sub.version = req->version;
+		sub.params = req + 1;
+		sub.params_size = req->params_size;
+		sub.response = resp + 1;
+		sub.response_max = req->response_max;
+		sub.send_response = host_command_batch_send_response;
+
+		/*
+		 * The batch itself was printed; only print its sub-commands
+		 * when printing every command.
+		 */
+		if (hcdebug >= HCDEBUG_EVERY)
+			host_command_debug_request(&sub);
+
+		if (!host_command_batchable(req->command))
+			resp->result = EC_RES_INVALID_PARAM;
+		else
+			resp->result = host_command_run(&sub);
+
+		/* Error results don't have data */
+		resp->response_size = resp->result ? 0 : sub.response_size;
+
+		in += sizeof(*req) + EC_BATCH_ALIGN(req->params_size);
+		out += sizeof(*resp) + EC_BATCH_ALIGN(resp->response_size);
+	}
+
+	r->num_cmds = i;
+	args->response_size = out - (uint8_t *)args->response;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_BATCH,
+		     host_command_batch,
+		     EC_VER_MASK(0));
+#endif /* CONFIG_HOSTCMD_BATCH */
+
 
 /*****************************************************************************/
 /* Console commands */
@@ -105,10 +105,16 @@ struct host_byte {
  *   20 -> i8042 (command)    # read CTR
  *
  * Hence, 5 (actually 4 plus one spare) is large enough, but use 8 for safety.
+ *
+ * Only the LPC interrupt adds to it and only the keyboard protocol task
+ * removes from it, so it uses the queue_spsc_* functions.
  */
 static struct queue const from_host = QUEUE_NULL(8, struct host_byte);
 
-/* Queue aux data to the host from interrupt context. */
+/*
+ * Queue aux data to the host from interrupt context.  Drained only by a
+ * deferred function, so it uses the queue_spsc_* functions.
+ */
 static struct queue const aux_to_host_queue = QUEUE_NULL(16, uint8_t);
 
 static int i8042_keyboard_irq_enabled;
@@ -216,7 +222,7 @@ void keyboard_host_write(int data, int is_cmd)
 
 	h.type = is_cmd ? HOST_COMMAND : HOST_DATA;
 	h.byte = data;
-	queue_add_unit(&from_host, &h);
+	queue_spsc_add_unit(&from_host, &h);
 	task_wake(TASK_ID_KEYPROTO);
 }
 
@@ -874,7 +880,7 @@ static void i8042_handle_from_host(void)
 	uint8_t output[MAX_SCAN_CODE_LEN];
 	uint8_t chan = CHAN_KBD;
 
-	while (queue_remove_unit(&from_host, &h)) {
+	while (queue_spsc_remove_unit(&from_host, &h)) {
 		if (h.type == HOST_COMMAND) {
 			ret_len = handle_keyboard_command(h.byte, output);
 		} else {
@@ -986,8 +992,7 @@ static void send_aux_data_to_host_deferred(void)
 		chipset_in_state(CHIPSET_STATE_ANY_SUSPEND))
 		device_set_single_event(EC_DEVICE_EVENT_TRACKPAD);
 
-	while (!queue_is_empty(&aux_to_host_queue)) {
-		queue_remove_unit(&aux_to_host_queue, &data);
+	while (queue_spsc_remove_unit(&aux_to_host_queue, &data)) {
 		if (aux_chan_enabled && IS_ENABLED(CONFIG_8042_AUX))
 			i8042_send_to_host(1, &data, CHAN_AUX);
 		else
@@ -1003,7 +1008,7 @@ DECLARE_DEFERRED(send_aux_data_to_host_deferred);
  */
 void send_aux_data_to_host_interrupt(uint8_t data)
 {
-	queue_add_unit(&aux_to_host_queue, &data);
+	queue_spsc_add_unit(&aux_to_host_queue, &data);
 	hook_call_deferred(&send_aux_data_to_host_deferred_data, 0);
 }
 
@@ -112,8 +112,45 @@ static uint32_t __bss_slow scan_time[SCAN_TIME_COUNT];
 /* Current scan_time[] index */
 static int __bss_slow scan_time_index;
 
-/* Index into scan_time[] when each key started debouncing */
-static uint8_t __bss_slow scan_edge_index[KEYBOARD_COLS_MAX][KEYBOARD_ROWS];
+/*
+ * Debounce time is tracked in ticks of 2^DEBOUNCE_TICK_SHIFT us, using
+ * vertical counters: bit b of debounce_count[b][c] is bit b of the tick count
+ * for the key at (row, c).  This lets one scan age every debouncing key in a
+ * column with a handful of byte-wide operations instead of a per-key loop.
+ */
+#define DEBOUNCE_TICK_SHIFT	9
+#define DEBOUNCE_COUNT_BITS	7
+#define DEBOUNCE_COUNT_MAX	(BIT(DEBOUNCE_COUNT_BITS) - 1)
+
+/* Ticks each debouncing key has been stable for, bit-sliced across rows */
+static uint8_t __bss_slow
+	debounce_count[DEBOUNCE_COUNT_BITS][KEYBOARD_COLS_MAX];
+/* Tick at which the debounce counters were last advanced */
+static uint32_t __bss_slow debounce_tick;
+
+/*
+ * Start of the window in which the changes seen by the next scan happened:
+ * the previous scan, or the wakeup which started polling.
+ */
+static uint32_t __bss_slow scan_window_start;
+
+/* Non-zero if the last scan saw keys debouncing or ghosting */
+static int __bss_slow scan_unsettled;
+
+/* Scan statistics, shown by the kbscanstats console command */
+struct scan_stats {
+	uint32_t scans;		/* Matrix scans */
+	uint32_t presses;	/* Key presses reported */
+	uint32_t reports;	/* Scans which reported a change */
+	uint64_t latency_us;	/* Sum of scan-to-report latencies */
+	uint32_t max_latency_us;/* Worst scan-to-report latency */
+};
+static struct scan_stats __bss_slow scan_stats;
+
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+/* Current time between start of scans when in polling mode */
+static uint32_t __bss_slow adaptive_period_us;
+#endif
 
 /* Minimum delay between keyboard scans based on current clock frequency */
 static uint32_t __bss_slow post_scan_clock_us;
@@ -232,6 +269,12 @@ static void simulate_key(int row, int col, int pressed)
 	ensure_keyboard_scanned(old_polls);
 	usleep(pressed ?
 	       keyscan_config.debounce_down_us : keyscan_config.debounce_up_us);
+
+	/* The task leaves polling mode as soon as keys settle, so poll again */
+	if (IS_ENABLED(CONFIG_KEYBOARD_SCAN_ADAPTIVE)) {
+		force_poll = 1;
+		task_wake(TASK_ID_KEYSCAN);
+	}
 	ensure_keyboard_scanned(kbd_polls);
 }
 
@@ -248,6 +291,8 @@ static void simulate_key(int row, int col, int pressed)
  */
 static int read_matrix(uint8_t *state)
 {
+	uint8_t active[KEYBOARD_COLS_MAX];
+	int num_active = 0;
 	int c;
 	int pressed = 0;
 
@@ -279,9 +324,15 @@ static int read_matrix(uint8_t *state)
 
 	/* 2. Detect transitional ghost */
 	for (c = 0; c < keyboard_cols; c++) {
-		int c2;
+		int i;
+
+		/* An empty column can't share a key with any other column */
+		if (!state[c])
+			continue;
+
+		for (i = 0; i < num_active; i++) {
+			int c2 = active[i];
 
-		for (c2 = 0; c2 < c; c2++) {
 			/*
 			 * If two columns shares at least one key but their
 			 * states are different, maybe the state changed between
@@ -299,6 +350,7 @@ static int read_matrix(uint8_t *state)
 				state[c] = state[c2] = merged;
 			}
 		}
+		active[num_active++] = c;
 	}
 
 	/* 3. Fix result */
@@ -476,30 +528,106 @@ static int check_runtime_keys(const uint8_t *state)
  */
 static int has_ghosting(const uint8_t *state)
 {
-	int c, c2;
+	uint8_t multi[KEYBOARD_COLS_MAX];
+	int num_multi = 0;
+	int c, i;
 
 	for (c = 0; c < keyboard_cols; c++) {
-		if (!state[c])
+		/*
+		 * Ghosting happens if 2 columns share at least 2 keys, so only
+		 * columns with more than one key pressed can be involved.
+		 * x&(x-1) is non-zero only if x has more than one bit set.
+		 */
+		if (!(state[c] & (state[c] - 1)))
 			continue;
 
-		for (c2 = c + 1; c2 < keyboard_cols; c2++) {
-			/*
-			 * A little bit of cleverness here.  Ghosting happens
-			 * if 2 columns share at least 2 keys.  So we OR the
-			 * columns together and then see if more than one bit
-			 * is set.  x&(x-1) is non-zero only if x has more than
-			 * one bit set.
-			 */
-			uint8_t common = state[c] & state[c2];
+		for (i = 0; i < num_multi; i++) {
+			uint8_t common = state[c] & multi[i];
 
 			if (common & (common - 1))
 				return 1;
 		}
+		multi[num_multi++] = state[c];
 	}
 
 	return 0;
 }
 
+/**
+ * Convert a debounce time to a tick count threshold.
+ *
+ * A key is only reported as debounced once a full debounce time has passed
+ * since its edge, so round up and add a tick for the unknown phase of the
+ * edge within its tick.  Times too long for the counters are clamped.
+ *
+ * @param us		Debounce time in us
+ *
+ * @return Number of ticks the key must be stable for.
+ */
+static uint8_t debounce_ticks(uint32_t us)
+{
+	uint32_t ticks = DIV_ROUND_UP(us, BIT(DEBOUNCE_TICK_SHIFT)) + 1;
+
+	return MIN(ticks, DEBOUNCE_COUNT_MAX);
+}
+
+/**
+ * Advance the debounce counters of a column.
+ *
+ * @param c		Column to advance
+ * @param mask		Keys in the column being debounced
+ * @param ticks		Ticks elapsed since the previous advance
+ */
+static void debounce_advance(int c, uint8_t mask, uint32_t ticks)
+{
+	uint8_t carry = 0;
+	int b;
+
+	if (ticks > DEBOUNCE_COUNT_MAX) {
+		carry = mask;
+	} else {
+		/* Ripple-carry add of ticks to every key in mask */
+		for (b = 0; b < DEBOUNCE_COUNT_BITS; b++) {
+			uint8_t x = debounce_count[b][c];
+			uint8_t y = (ticks & BIT(b)) ? mask : 0;
+
+			debounce_count[b][c] = x ^ y ^ carry;
+			carry = (x & y) | (carry & (x ^ y));
+		}
+	}
+
+	/* Saturate counters which overflowed */
+	for (b = 0; b < DEBOUNCE_COUNT_BITS; b++)
+		debounce_count[b][c] |= carry;
+}
+
+/**
+ * Compare the debounce counters of a column against a threshold.
+ *
+ * @param c		Column to compare
+ * @param ticks		Threshold
+ *
+ * @return Mask of keys in the column whose counter is >= ticks.
+ */
+static uint8_t debounce_reached(int c, uint8_t ticks)
+{
+	uint8_t gt = 0, eq = 0xff;
+	int b;
+
+	for (b = DEBOUNCE_COUNT_BITS - 1; b >= 0; b--) {
+		uint8_t x = debounce_count[b][c];
+
+		if (ticks & BIT(b)) {
+			eq &= x;
+		} else {
+			gt |= eq & x;
+			eq &= ~x;
+		}
+	}
+
+	return gt | eq;
+}
+
 /**
  * Update keyboard state using low-level interface to read keyboard.
  *
@@ -507,50 +635,68 @@ static int has_ghosting(const uint8_t *state)
  *
  * @return 1 if any key is still pressed, 0 if no key is pressed.
  */
-static int check_keys_changed(uint8_t *state)
+test_export_static int check_keys_changed(uint8_t *state)
 {
 	int any_pressed = 0;
 	int c, i;
 	int any_change = 0;
 	static uint8_t __bss_slow new_state[KEYBOARD_COLS_MAX];
 	uint32_t tnow = get_time().le.lo;
+	uint32_t tick, ticks, window_start;
+	uint8_t down_ticks, up_ticks;
 
 	/* Save the current scan time */
 	if (++scan_time_index >= SCAN_TIME_COUNT)
 		scan_time_index = 0;
 	scan_time[scan_time_index] = tnow;
+	window_start = scan_window_start;
+	scan_window_start = tnow;
+	scan_stats.scans++;
 
 	/* Read the raw key state */
 	any_pressed = read_matrix(new_state);
 
 	/* Ignore if so many keys are pressed that we're ghosting. */
-	if (has_ghosting(new_state))
+	if (has_ghosting(new_state)) {
+		scan_unsettled = 1;
 		return any_pressed;
+	}
+	scan_unsettled = 0;
+
+	/* Ticks elapsed since the debounce counters were last advanced */
+	tick = tnow >> DEBOUNCE_TICK_SHIFT;
+	ticks = (tick - debounce_tick) & (UINT32_MAX >> DEBOUNCE_TICK_SHIFT);
+	debounce_tick = tick;
+	down_ticks = debounce_ticks(keyscan_config.debounce_down_us);
+	up_ticks = debounce_ticks(keyscan_config.debounce_up_us);
 
 	/* Check for changes between previous scan and this one */
 	for (c = 0; c < keyboard_cols; c++) {
 		int diff;
 
-		/* Clear debouncing flag, if sufficient time has elapsed. */
-		for (i = 0; i < KEYBOARD_ROWS && debouncing[c]; i++) {
-			if (!(debouncing[c] & BIT(i)))
-				continue;
-			if (tnow - scan_time[scan_edge_index[c][i]] <
-			    (state[c] ? keyscan_config.debounce_down_us :
-					keyscan_config.debounce_up_us))
-				continue;  /* Not done debouncing */
-			debouncing[c] &= ~BIT(i);
+		/*
+		 * Clear debouncing flag, if sufficient time has elapsed.  Keys
+		 * now down are debouncing a press, keys now up a release.
+		 */
+		if (debouncing[c]) {
+			debounce_advance(c, debouncing[c], ticks);
+			debouncing[c] &= ~(
+				(state[c] & debounce_reached(c, down_ticks)) |
+				(~state[c] & debounce_reached(c, up_ticks)));
 		}
 
 		/* Recognize change in state, unless debounce in effect. */
 		diff = (new_state[c] ^ state[c]) & ~debouncing[c];
-		if (!diff)
+		if (!diff) {
+			scan_unsettled |= debouncing[c];
 			continue;
+		}
 		for (i = 0; i < KEYBOARD_ROWS; i++) {
 			if (!(diff & BIT(i)))
 				continue;
-			scan_edge_index[c][i] = scan_time_index;
 			any_change = 1;
+			if (new_state[c] & BIT(i))
+				scan_stats.presses++;
 
 			/* Inform keyboard module if scanning is enabled */
 			if (keyboard_scan_is_enabled()) {
@@ -564,6 +710,9 @@ static int check_keys_changed(uint8_t *state)
 
 		/* For any keyboard events just sent, turn on debouncing. */
 		debouncing[c] |= diff;
+		for (i = 0; i < DEBOUNCE_COUNT_BITS; i++)
+			debounce_count[i][c] &= ~diff;
+		scan_unsettled |= debouncing[c];
 		/*
 		 * Note: In order to "remember" what was last reported
 		 * (up or down), the state bits are only updated if the
@@ -573,6 +722,12 @@ static int check_keys_changed(uint8_t *state)
 	}
 
 	if (any_change) {
+		uint32_t latency = get_time().le.lo - window_start;
+
+		scan_stats.reports++;
+		scan_stats.latency_us += latency;
+		if (latency > scan_stats.max_latency_us)
+			scan_stats.max_latency_us = latency;
 
 #ifdef CONFIG_KEYBOARD_SUPPRESS_NOISE
 		/* Suppress keyboard noise */
@@ -764,9 +919,52 @@ void keyboard_scan_init(void)
 #endif /* CONFIG_KEYBOARD_BOOT_KEYS */
 }
 
+/**
+ * Return the time until the next scan start when in polling mode.
+ *
+ * With CONFIG_KEYBOARD_SCAN_ADAPTIVE this also adapts the period to the last
+ * scan: back to the configured period while keys are settling, otherwise
+ * twice as long, up to CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US.
+ */
+static uint32_t next_scan_period(void)
+{
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+	if (scan_unsettled)
+		adaptive_period_us = keyscan_config.scan_period_us;
+	else if (adaptive_period_us <
+			CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US)
+		adaptive_period_us = MIN(adaptive_period_us * 2,
+				CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US);
+
+	return adaptive_period_us;
+#else
+	return keyscan_config.scan_period_us;
+#endif
+}
+
+/**
+ * Wait between scans with the keyboard interrupt armed.
+ *
+ * Used while keys are held steady, so that a new key press ends the wait and
+ * gets scanned right away instead of after the full scan period.  Only a row
+ * going active raises the interrupt: releases and presses on an already
+ * active row wait for the timeout.
+ *
+ * @param us		Maximum time to wait
+ */
+static void wait_for_new_key(int us)
+{
+	keyboard_raw_drive_column(KEYBOARD_COLUMN_ALL);
+	keyboard_raw_enable_interrupt(1);
+	task_wait_event(us);
+	keyboard_raw_enable_interrupt(0);
+	keyboard_raw_drive_column(KEYBOARD_COLUMN_NONE);
+}
+
 void keyboard_scan_task(void *u)
 {
 	timestamp_t poll_deadline, start;
+	uint32_t period;
 	int wait_time;
 	uint32_t local_disable_scanning = 0;
 
@@ -834,6 +1032,10 @@ void keyboard_scan_task(void *u)
 		CPRINTS5("KB poll");
 		keyboard_raw_enable_interrupt(0);
 		keyboard_raw_drive_column(KEYBOARD_COLUMN_NONE);
+		scan_window_start = get_time().le.lo;
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+		adaptive_period_us = keyscan_config.scan_period_us;
+#endif
 
 		/* Busy polling keyboard state. */
 		while (keyboard_scan_is_enabled()) {
@@ -845,11 +1047,15 @@ void keyboard_scan_task(void *u)
 					+ keyscan_config.poll_timeout_us;
 			} else if (timestamp_expired(poll_deadline, &start)) {
 				break;
+			} else if (IS_ENABLED(CONFIG_KEYBOARD_SCAN_ADAPTIVE) &&
+				   !scan_unsettled) {
+				/* All keys released and debounced */
+				break;
 			}
 
 			/* Delay between scans */
-			wait_time = keyscan_config.scan_period_us -
-				(get_time().val - start.val);
+			period = next_scan_period();
+			wait_time = period - (get_time().val - start.val);
 
 			if (wait_time < keyscan_config.min_post_scan_delay_us)
 				wait_time =
@@ -858,7 +1064,10 @@ void keyboard_scan_task(void *u)
 			if (wait_time < post_scan_clock_us)
 				wait_time = post_scan_clock_us;
 
-			usleep(wait_time);
+			if (period > keyscan_config.scan_period_us)
+				wait_for_new_key(wait_time);
+			else
+				usleep(wait_time);
 		}
 	}
 }
@@ -1050,6 +1259,38 @@ DECLARE_CONSOLE_COMMAND(ksstate, command_ksstate,
 			"ksstate [on | off | force]",
 			"Show or toggle printing keyboard scan state");
 
+static int command_kbscanstats(int argc, char **argv)
+{
+	uint32_t reports = scan_stats.reports;
+	uint64_t avg_latency = scan_stats.latency_us;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "clear"))
+			return EC_ERROR_PARAM1;
+		memset(&scan_stats, 0, sizeof(scan_stats));
+		return EC_SUCCESS;
+	}
+
+	ccprintf("Scans:          %u\n", scan_stats.scans);
+	ccprintf("Key presses:    %u\n", scan_stats.presses);
+	if (scan_stats.presses)
+		ccprintf("Scans/press:    %u\n",
+			 scan_stats.scans / scan_stats.presses);
+	ccprintf("Reports:        %u\n", reports);
+	if (reports) {
+		uint64divmod(&avg_latency, reports);
+		ccprintf("Latency:        %u us avg, %u us max\n",
+			 (uint32_t)avg_latency, scan_stats.max_latency_us);
+	}
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+	ccprintf("Scan period:    %u us\n", adaptive_period_us);
+#endif
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(kbscanstats, command_kbscanstats,
+			"[clear]",
+			"Show or clear keyboard scan statistics");
+
 static int command_keyboard_press(int argc, char **argv)
 {
 	if (argc == 1) {
@@ -89,6 +89,9 @@ test_mockable __keep int main(void)
 	 */
 	task_pre_init();
 
+	/* Sort the hook tables before anything can call hook_notify(). */
+	hook_pre_init();
+
 	/*
 	 * Initialize the system module.  This enables the hibernate clock
 	 * source we need to calibrate the internal oscillator.
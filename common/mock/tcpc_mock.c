@@ -43,6 +43,8 @@ static int mock_release(int port)
 static int mock_get_cc(int port, enum tcpc_cc_voltage_status *cc1,
 		       enum tcpc_cc_voltage_status *cc2)
 {
+	++mock_tcpc.num_calls_to_get_cc;
+
 	*cc1 = mock_tcpc.cc1;
 	*cc2 = mock_tcpc.cc2;
 	return EC_SUCCESS;
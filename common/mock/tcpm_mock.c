@@ -8,6 +8,8 @@
 #include "console.h"
 #include "memory.h"
 #include "mock/tcpm_mock.h"
+#include "task.h"
+#include "usb_pd.h"
 
 struct mock_tcpm_t mock_tcpm[CONFIG_USB_PD_PORT_MAX_COUNT];
 
@@ -65,4 +67,7 @@ void mock_tcpm_rx_msg(int port, uint16_t header, int cnt, const uint32_t *data)
 			mock_tcpm[port].mock_rx_chk_buf[idx] = data[idx];
 	}
 	mock_tcpm[port].mock_has_pending_message = 1;
+
+	/* Wake the PD task like a real TCPC alert would */
+	task_set_event(PD_PORT_TO_TASK_ID(port), TASK_EVENT_WAKE, 0);
 }
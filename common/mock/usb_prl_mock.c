@@ -6,7 +6,9 @@
  */
 #include <string.h>
 #include "common.h"
+#include "task.h"
 #include "usb_emsg.h"
+#include "usb_pd.h"
 #include "usb_pe_sm.h"
 #include "usb_prl_sm.h"
 #include "mock/usb_prl_mock.h"
@@ -119,16 +121,19 @@ void fake_prl_clear_last_sent_data_msg(int port)
 void fake_prl_message_sent(int port)
 {
 	mock_prl_port[port].message_sent = 1;
+	task_wake(PD_PORT_TO_TASK_ID(port));
 }
 
 void fake_prl_message_received(int port)
 {
 	mock_prl_port[port].message_received = 1;
+	task_wake(PD_PORT_TO_TASK_ID(port));
 }
 
 void fake_prl_report_error(int port, enum pe_error e)
 {
 	mock_prl_port[port].pe_error = e;
+	task_wake(PD_PORT_TO_TASK_ID(port));
 }
 
 void prl_run(int port, int evt, int en)
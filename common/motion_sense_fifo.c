@@ -67,6 +67,20 @@ static uint32_t next_timestamp_initialized;
 /** Need to wake up the AP. */
 static int wake_up_needed;
 
+/**
+ * Samples collected by the sensor drivers, staged together by
+ * motion_sense_fifo_batch_stage(). Only used from the motion sense task.
+ */
+static struct ec_response_motion_sensor_data
+	batch[CONFIG_ACCEL_FIFO_BATCH_SIZE];
+/** Number of samples in the batch. */
+static int batch_count;
+/** Time at which the samples in the batch were taken. */
+static uint32_t batch_time;
+
+/** Sample periods used to spread timestamps in the current commit. */
+static uint32_t data_periods[MAX_MOTION_SENSORS];
+
 /**
  * Check whether or not a give sensor data entry is a timestamp or not.
  *
@@ -222,6 +236,9 @@ static inline bool is_new_timestamp(uint8_t sensor_num)
  * Stage a single data unit to the motion sense fifo. Note that for the AP to
  * see this data, it must be committed.
  *
+ * WARNING: This function MUST be called from within a locked context of
+ * g_sensor_mutex.
+ *
  * @param data The data to stage.
  * @param sensor The sensor that generated the data
  * @param valid_data The number of readable data entries in the data.
@@ -234,8 +251,6 @@ static void fifo_stage_unit(
 	struct queue_chunk chunk;
 	int i;
 
-	mutex_lock(&g_sensor_mutex);
-
 	for (i = 0; i < valid_data; i++)
 		sensor->xyz[i] = data->data[i];
 
@@ -261,12 +276,14 @@ static void fifo_stage_unit(
 			sensor->oversampling %= sensor->oversampling_ratio;
 		}
 		if (removed) {
-			mutex_unlock(&g_sensor_mutex);
 			if (IS_ENABLED(CONFIG_ONLINE_CALIB) &&
-			    next_timestamp_initialized & BIT(data->sensor_num))
+			    next_timestamp_initialized & BIT(data->sensor_num)) {
+				mutex_unlock(&g_sensor_mutex);
 				online_calibration_process_data(
 					data, sensor,
 					next_timestamp[data->sensor_num].next);
+				mutex_lock(&g_sensor_mutex);
+			}
 			return;
 		}
 	}
@@ -292,7 +309,6 @@ static void fifo_stage_unit(
 		 * address 0. Just don't add any data to the queue instead.
 		 */
 		CPRINTS("Failed to get write chunk for new fifo data!");
-		mutex_unlock(&g_sensor_mutex);
 		return;
 	}
 
@@ -317,13 +333,14 @@ static void fifo_stage_unit(
 	    !is_timestamp(data) &&
 	    ++fifo_staged.sample_count[data->sensor_num] > 1)
 		fifo_staged.requires_spreading = 1;
-
-	mutex_unlock(&g_sensor_mutex);
 }
 
 /**
  * Stage an entry representing a single timestamp.
  *
+ * WARNING: This function MUST be called from within a locked context of
+ * g_sensor_mutex.
+ *
  * @param timestamp The timestamp to add to the fifo.
  * @param sensor_num The sensor number that this timestamp came from (use 0xff
  *	  for unknown).
@@ -338,20 +355,6 @@ static void fifo_stage_timestamp(uint32_t timestamp, uint8_t sensor_num)
 	fifo_stage_unit(&vector, NULL, 0);
 }
 
-/**
- * Peek into the staged data at a given offset. This function performs no bound
- * checking and is purely for confinience.
- *
- * @param offset The offset into the staged data to peek into.
- * @return Pointer to the entry at the given offset.
- */
-static inline struct ec_response_motion_sensor_data *
-peek_fifo_staged(size_t offset)
-{
-	return (struct ec_response_motion_sensor_data *)
-		queue_get_write_chunk(&fifo, offset).buffer;
-}
-
 void motion_sense_fifo_init(void)
 {
 	if (IS_ENABLED(CONFIG_ONLINE_CALIB))
@@ -385,17 +388,27 @@ void motion_sense_fifo_insert_async_event(
 	vector.timestamp = __hw_clock_source_read();
 	vector.sensor_num = sensor - motion_sensors;
 
+	mutex_lock(&g_sensor_mutex);
 	fifo_stage_unit(&vector, sensor, 0);
+	mutex_unlock(&g_sensor_mutex);
 	motion_sense_fifo_commit_data();
 }
 
 inline void motion_sense_fifo_add_timestamp(uint32_t timestamp)
 {
+	mutex_lock(&g_sensor_mutex);
 	fifo_stage_timestamp(timestamp, 0xff);
+	mutex_unlock(&g_sensor_mutex);
 	motion_sense_fifo_commit_data();
 }
 
-void motion_sense_fifo_stage_data(
+/**
+ * Stage a data unit, preceded by its timestamp when using tight timestamps.
+ *
+ * WARNING: This function MUST be called from within a locked context of
+ * g_sensor_mutex.
+ */
+static void fifo_stage_data(
 	struct ec_response_motion_sensor_data *data,
 	struct motion_sensor_t *sensor,
 	int valid_data,
@@ -410,18 +423,112 @@ void motion_sense_fifo_stage_data(
 	fifo_stage_unit(data, sensor, valid_data);
 }
 
+void motion_sense_fifo_stage_data(
+	struct ec_response_motion_sensor_data *data,
+	struct motion_sensor_t *sensor,
+	int valid_data,
+	uint32_t time)
+{
+	mutex_lock(&g_sensor_mutex);
+	fifo_stage_data(data, sensor, valid_data, time);
+	mutex_unlock(&g_sensor_mutex);
+}
+
+void motion_sense_fifo_stage_batch(
+	struct ec_response_motion_sensor_data *data,
+	int count,
+	uint32_t time)
+{
+	int i;
+
+	mutex_lock(&g_sensor_mutex);
+	for (i = 0; i < count; i++)
+		fifo_stage_data(&data[i], &motion_sensors[data[i].sensor_num],
+				3, time);
+	mutex_unlock(&g_sensor_mutex);
+}
+
+void motion_sense_fifo_batch_add(
+	const struct ec_response_motion_sensor_data *data,
+	uint32_t time)
+{
+	if (batch_count &&
+	    (batch_count == ARRAY_SIZE(batch) || time != batch_time))
+		motion_sense_fifo_batch_stage();
+
+	batch[batch_count++] = *data;
+	batch_time = time;
+}
+
+void motion_sense_fifo_batch_stage(void)
+{
+	motion_sense_fifo_stage_batch(batch, batch_count, batch_time);
+	batch_count = 0;
+}
+
+/**
+ * Commit a single staged data entry: spread the timestamp staged right before
+ * it and feed it to the online calibration.
+ *
+ * WARNING: This function MUST be called from within a locked context of
+ * g_sensor_mutex.
+ *
+ * @param ts The staged entry before the data, expected to be its timestamp.
+ * @param data The staged data entry.
+ */
+static void fifo_commit_unit(struct ec_response_motion_sensor_data *ts,
+			     struct ec_response_motion_sensor_data *data)
+{
+	int sensor_num = data->sensor_num;
+
+	/* Verify we're pointing at a timestamp. */
+	if (!ts || !is_timestamp(ts)) {
+		CPRINTS("FIFO entries out of order,"
+			" expected timestamp");
+		return;
+	}
+
+	/*
+	 * If this is the first time we're seeing a timestamp for this
+	 * sensor or the timestamp is after our computed next, skip
+	 * ahead.
+	 */
+	if (!(next_timestamp_initialized & BIT(sensor_num)) ||
+	    time_after(ts->timestamp, next_timestamp[sensor_num].prev)) {
+		next_timestamp[sensor_num].next = ts->timestamp;
+		next_timestamp_initialized |= BIT(sensor_num);
+	}
+
+	/* Spread the timestamp and compute the expected next. */
+	ts->timestamp = next_timestamp[sensor_num].next;
+	next_timestamp[sensor_num].prev = next_timestamp[sensor_num].next;
+	next_timestamp[sensor_num].next +=
+		fifo_staged.requires_spreading
+		? data_periods[sensor_num]
+		: motion_sensors[sensor_num].collection_rate;
+
+	/* Update online calibration if enabled. */
+	if (IS_ENABLED(CONFIG_ONLINE_CALIB))
+		online_calibration_process_data(
+			data, &motion_sensors[sensor_num],
+			next_timestamp[sensor_num].prev);
+}
+
 void motion_sense_fifo_commit_data(void)
 {
-	/* Cached data periods, static to store off stack. */
-	static uint32_t data_periods[MAX_MOTION_SENSORS];
-	struct ec_response_motion_sensor_data *data;
-	int i, window, sensor_num;
+	struct ec_response_motion_sensor_data *data, *prev = NULL;
+	struct queue_chunk chunks[2];
+	int c, i, units, left, window;
 
 	/* Nothing staged, no work to do. */
 	if (!fifo_staged.count)
 		return;
 
 	mutex_lock(&g_sensor_mutex);
+
+	/* The staged entries are the first units of free space in the queue */
+	queue_get_write_chunks(&fifo, chunks);
+
 	/*
 	 * If per-sensor event counts are never more than 1, no spreading is
 	 * needed. This will also catch cases where tight timestamps aren't
@@ -430,7 +537,7 @@ void motion_sense_fifo_commit_data(void)
 	if (!fifo_staged.requires_spreading)
 		goto commit_data_end;
 
-	data = peek_fifo_staged(0);
+	data = chunks[0].buffer;
 
 	/*
 	 * Spreading only makes sense if tight timestamps are used. In such case
@@ -472,59 +579,24 @@ commit_data_end:
 	 *
 	 * If we got this far that means that the tight timestamps config is
 	 * enabled. This means that we can expect the staged entries to have 1
-	 * or more timestamps followed by exactly 1 data entry. We'll loop
-	 * through the timestamps until we get to data. We only need to update
-	 * the timestamp right before it to keep things correct.
+	 * or more timestamps followed by exactly 1 data entry. We'll walk
+	 * the staged entries in one pass, over the (at most two) spans of the
+	 * queue buffer they occupy, and only need to update the timestamp
+	 * right before each data entry to keep things correct.
 	 */
-	for (i = 0; i < fifo_staged.count; i++) {
-		data = peek_fifo_staged(i);
-		if (data->flags & MOTIONSENSE_SENSOR_FLAG_WAKEUP)
-			wake_up_needed = 1;
-
-		/*
-		 * Skip non-data entries, we don't know the sensor number yet.
-		 */
-		if (!is_data(data))
-			continue;
-
-		/* Get the sensor number and point to the timestamp entry. */
-		sensor_num = data->sensor_num;
-		data = peek_fifo_staged(i - 1);
-
-		/* Verify we're pointing at a timestamp. */
-		if (!is_timestamp(data)) {
-			CPRINTS("FIFO entries out of order,"
-				" expected timestamp");
-			continue;
+	left = fifo_staged.count;
+	for (c = 0; c < ARRAY_SIZE(chunks) && left; c++) {
+		units = MIN((int)chunks[c].count, left);
+		left -= units;
+
+		for (data = chunks[c].buffer; units--; prev = data++) {
+			if (data->flags & MOTIONSENSE_SENSOR_FLAG_WAKEUP)
+				wake_up_needed = 1;
+
+			/* Skip non-data entries, they have no sensor to spread */
+			if (is_data(data))
+				fifo_commit_unit(prev, data);
 		}
-
-		/*
-		 * If this is the first time we're seeing a timestamp for this
-		 * sensor or the timestamp is after our computed next, skip
-		 * ahead.
-		 */
-		if (!(next_timestamp_initialized & BIT(sensor_num)) ||
-		    time_after(data->timestamp,
-			       next_timestamp[sensor_num].prev)) {
-			next_timestamp[sensor_num].next = data->timestamp;
-			next_timestamp_initialized |= BIT(sensor_num);
-		}
-
-		/* Spread the timestamp and compute the expected next. */
-		data->timestamp = next_timestamp[sensor_num].next;
-		next_timestamp[sensor_num].prev =
-			next_timestamp[sensor_num].next;
-		next_timestamp[sensor_num].next +=
-			fifo_staged.requires_spreading
-			? data_periods[sensor_num]
-			: motion_sensors[sensor_num].collection_rate;
-
-		/* Update online calibration if enabled. */
-		data = peek_fifo_staged(i);
-		if (IS_ENABLED(CONFIG_ONLINE_CALIB))
-			online_calibration_process_data(
-				data, &motion_sensors[sensor_num],
-				next_timestamp[sensor_num].prev);
 	}
 
 	/* Advance the tail and clear the staged metadata. */
@@ -593,6 +665,7 @@ int motion_sense_fifo_read(int capacity_bytes, int max_count, void *out,
 void motion_sense_fifo_reset(void)
 {
 	next_timestamp_initialized = 0;
+	batch_count = 0;
 	memset(&fifo_staged, 0, sizeof(fifo_staged));
 	motion_sense_fifo_init();
 	queue_init(&fifo);
@@ -100,8 +100,33 @@ static int print_hex_buffer(int (*addchar)(void *context, int c),
 	return EC_SUCCESS;
 }
 
+/*
+ * Send a run of characters, in one call if the output supports it.
+ * Returns 0 on success or an error on failure.
+ */
+static int print_span(int (*addchar)(void *context, int c),
+		      int (*addspan)(void *context, const char *s, int len),
+		      void *context, const char *s, int len)
+{
+	if (addspan)
+		return addspan(context, s, len) ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+
+	while (len--)
+		if (addchar(context, *s++))
+			return EC_ERROR_OVERFLOW;
+
+	return EC_SUCCESS;
+}
+
 int vfnprintf(int (*addchar)(void *context, int c), void *context,
 	      const char *format, va_list args)
+{
+	return vfnprintf_span(addchar, NULL, context, format, args);
+}
+
+int vfnprintf_span(int (*addchar)(void *context, int c),
+		   int (*addspan)(void *context, const char *s, int len),
+		   void *context, const char *format, va_list args)
 {
 	/*
 	 * Longest uint64 in decimal = 20
@@ -120,9 +145,14 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		int c = *format++;
 		char sign = 0;
 
-		/* Copy normal characters */
+		/* Copy normal characters, up to the next format */
 		if (c != '%') {
-			if (addchar(context, c))
+			const char *run = format - 1;
+
+			while (*format && *format != '%')
+				format++;
+			if (print_span(addchar, addspan, context, run,
+				       format - run))
 				return EC_ERROR_OVERFLOW;
 			continue;
 		}
@@ -432,7 +462,6 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		if (precision < 0) {
 			/* If precision is unset, print everything */
 			vlen = strlen(vstr);
-			precision = MAX(vlen, pad_width);
 		} else {
 			/*
 			 * If precision is set, ensure that we do not
@@ -442,14 +471,16 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		}
 
 
+		/* vlen is exactly the number of characters to print */
+		precision = vlen;
+
 		while (vlen < pad_width && !(flags & PF_LEFT)) {
 			if (addchar(context, flags & PF_PADZERO ? '0' : ' '))
 				return EC_ERROR_OVERFLOW;
 			vlen++;
 		}
-		while (--precision >= 0 && *vstr)
-			if (addchar(context, *vstr++))
-				return EC_ERROR_OVERFLOW;
+		if (print_span(addchar, addspan, context, vstr, precision))
+			return EC_ERROR_OVERFLOW;
 		while (vlen < pad_width && flags & PF_LEFT) {
 			if (addchar(context, ' '))
 				return EC_ERROR_OVERFLOW;
@@ -486,6 +517,25 @@ static int snprintf_addchar(void *context, int c)
 	return 0;
 }
 
+/**
+ * Add a run of characters to the string context.
+ *
+ * @param context	Context receiving characters
+ * @param s		Characters to add
+ * @param len		Number of characters
+ * @return 0 if all added, 1 if some were dropped because no space.
+ */
+static int snprintf_addspan(void *context, const char *s, int len)
+{
+	struct snprintf_context *ctx = (struct snprintf_context *)context;
+	int n = MIN(len, ctx->size);
+
+	memcpy(ctx->str, s, n);
+	ctx->str += n;
+	ctx->size -= n;
+	return n != len;
+}
+
 int snprintf(char *str, int size, const char *format, ...)
 {
 	va_list args;
@@ -509,7 +559,8 @@ int vsnprintf(char *str, int size, const char *format, va_list args)
 	ctx.str = str;
 	ctx.size = size - 1;  /* Reserve space for terminating '\0' */
 
-	rv = vfnprintf(snprintf_addchar, &ctx, format, args);
+	rv = vfnprintf_span(snprintf_addchar, snprintf_addspan, &ctx, format,
+			    args);
 
 	/* Terminate string */
 	*ctx.str = '\0';
@@ -104,6 +104,46 @@ struct queue_chunk queue_get_read_chunk(struct queue const *q)
 	});
 }
 
+/*
+ * Fill in up to two chunks: count units from index, of which the ones past
+ * the end of the buffer wrap to its start.
+ */
+static size_t queue_get_chunks(struct queue const *q, size_t index,
+			       size_t count, struct queue_chunk chunks[2])
+{
+	size_t offset = index & q->buffer_units_mask;
+	size_t first = MIN(count, q->buffer_units - offset);
+
+	chunks[0] = ((struct queue_chunk) {
+		.count = first,
+		.buffer = first ? q->buffer + offset * q->unit_bytes : NULL,
+	});
+	chunks[1] = ((struct queue_chunk) {
+		.count = count - first,
+		.buffer = (count > first) ? q->buffer : NULL,
+	});
+
+	return count;
+}
+
+size_t queue_get_write_chunks(struct queue const *q,
+			      struct queue_chunk chunks[2])
+{
+	size_t tail = q->state->tail;
+
+	return queue_get_chunks(q, tail,
+				q->buffer_units - (tail - q->state->head),
+				chunks);
+}
+
+size_t queue_get_read_chunks(struct queue const *q,
+			     struct queue_chunk chunks[2])
+{
+	size_t head = q->state->head;
+
+	return queue_get_chunks(q, head, q->state->tail - head, chunks);
+}
+
 size_t queue_advance_head(struct queue const *q, size_t count)
 {
 	size_t transfer = MIN(count, queue_count(q));
@@ -252,6 +292,106 @@ size_t queue_peek_memcpy(struct queue const *q,
 	return transfer;
 }
 
+/*
+ * Single-producer/single-consumer access.  The producer owns the tail and the
+ * consumer owns the head: each reads the other's index with acquire ordering,
+ * so that it sees the units (or free space) behind it, and publishes its own
+ * with release ordering, after its copy.
+ */
+static inline size_t queue_spsc_load(size_t volatile *index)
+{
+	return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static inline void queue_spsc_store(size_t volatile *index, size_t value)
+{
+	__atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+size_t queue_spsc_add_unit(struct queue const *q, const void *src)
+{
+	size_t tail = q->state->tail;
+
+	if (tail - queue_spsc_load(&q->state->head) == q->buffer_units)
+		return 0;
+
+	if (q->unit_bytes == 1)
+		q->buffer[tail & q->buffer_units_mask] = *((uint8_t *) src);
+	else
+		memcpy(q->buffer + (tail & q->buffer_units_mask) *
+		       q->unit_bytes, src, q->unit_bytes);
+
+	queue_spsc_store(&q->state->tail, tail + 1);
+	q->policy->add(q->policy, 1);
+
+	return 1;
+}
+
+size_t queue_spsc_add_units(struct queue const *q, const void *src,
+			    size_t count)
+{
+	size_t tail = q->state->tail;
+	size_t space = q->buffer_units -
+		       (tail - queue_spsc_load(&q->state->head));
+	size_t transfer = MIN(count, space);
+	size_t offset = tail & q->buffer_units_mask;
+	size_t first = MIN(transfer, q->buffer_units - offset);
+
+	if (!transfer)
+		return 0;
+
+	memcpy(q->buffer + offset * q->unit_bytes, src,
+	       first * q->unit_bytes);
+
+	if (first < transfer)
+		memcpy(q->buffer,
+		       ((uint8_t const *) src) + first * q->unit_bytes,
+		       (transfer - first) * q->unit_bytes);
+
+	queue_spsc_store(&q->state->tail, tail + transfer);
+	q->policy->add(q->policy, transfer);
+
+	return transfer;
+}
+
+size_t queue_spsc_remove_unit(struct queue const *q, void *dest)
+{
+	size_t head = q->state->head;
+
+	if (queue_spsc_load(&q->state->tail) == head)
+		return 0;
+
+	if (q->unit_bytes == 1)
+		*((uint8_t *) dest) = q->buffer[head & q->buffer_units_mask];
+	else
+		memcpy(dest, q->buffer + (head & q->buffer_units_mask) *
+		       q->unit_bytes, q->unit_bytes);
+
+	queue_spsc_store(&q->state->head, head + 1);
+	q->policy->remove(q->policy, 1);
+
+	return 1;
+}
+
+size_t queue_spsc_remove_units(struct queue const *q, void *dest,
+			       size_t count)
+{
+	size_t head = q->state->head;
+	size_t transfer = MIN(count,
+			      queue_spsc_load(&q->state->tail) - head);
+
+	if (!transfer)
+		return 0;
+
+	queue_read_safe(q, dest, head & q->buffer_units_mask, transfer,
+			memcpy);
+
+	queue_spsc_store(&q->state->head, head + transfer);
+	q->policy->remove(q->policy, transfer);
+
+	return transfer;
+}
+
 void queue_begin(struct queue const *q, struct queue_iterator *it)
 {
 	if (queue_is_empty(q))
@@ -12,6 +12,8 @@
 #include "sha256.h"
 #include "util.h"
 
+#ifndef CONFIG_RSA_64BIT_LIMBS
+
 /**
  * a[] -= mod
  */
@@ -178,6 +180,213 @@ static void mod_pow(const struct rsa_public_key *key, uint8_t *inout,
 	}
 }
 
+#else /* CONFIG_RSA_64BIT_LIMBS */
+
+#ifndef __SIZEOF_INT128__
+#error CONFIG_RSA_64BIT_LIMBS requires a compiler with 128-bit integers
+#endif
+
+/*
+ * Same Montgomery arithmetic as above, on 64-bit limbs. R is unchanged
+ * (2^(32 * RSANUMWORDS)), so the key's rr can be used as is; only n0inv needs
+ * to be extended to 64 bits.
+ */
+
+typedef unsigned __int128 uint128_t;
+
+#define RSANUMLIMBS (RSANUMWORDS / 2)
+
+/* Limb i of a little endian 32-bit word array */
+static inline uint64_t key_limb(const uint32_t *w, int i)
+{
+	return ((uint64_t)w[2 * i + 1] << 32) | w[2 * i];
+}
+
+/**
+ * Return -1 / n[0] mod 2^64, from the key's 32-bit n0inv.
+ */
+static uint64_t get_n0inv64(const struct rsa_public_key *key)
+{
+	uint64_t n0 = key_limb(key->n, 0);
+	uint64_t inv = (uint32_t)-key->n0inv;  /* 1 / n[0] mod 2^32 */
+
+	/* One Newton iteration doubles the number of correct bits. */
+	inv *= 2 - n0 * inv;
+
+	return -inv;
+}
+
+/**
+ * a[] -= mod
+ */
+static void sub_mod64(const struct rsa_public_key *key, uint64_t *a)
+{
+	uint64_t borrow = 0;
+	uint32_t i;
+
+	for (i = 0; i < RSANUMLIMBS; ++i) {
+		uint128_t A = (uint128_t)a[i] - key_limb(key->n, i) - borrow;
+
+		a[i] = (uint64_t)A;
+		borrow = (uint64_t)(A >> 64) & 1;
+	}
+}
+
+/**
+ * Return a[] >= mod
+ */
+static int ge_mod64(const struct rsa_public_key *key, const uint64_t *a)
+{
+	uint32_t i;
+
+	for (i = RSANUMLIMBS; i;) {
+		uint64_t n;
+
+		--i;
+		n = key_limb(key->n, i);
+		if (a[i] < n)
+			return 0;
+		if (a[i] > n)
+			return 1;
+	}
+	return 1;  /* equal */
+}
+
+/**
+ * Montgomery c[] += a * b[] / R % mod
+ */
+static void mont_mul_add64(const struct rsa_public_key *key, uint64_t n0inv,
+			   uint64_t *c, const uint64_t a, const uint64_t *b)
+{
+	uint128_t A = (uint128_t)a * b[0] + c[0];
+	uint64_t d0 = (uint64_t)A * n0inv;
+	uint128_t B = (uint128_t)d0 * key_limb(key->n, 0) + (uint64_t)A;
+	uint32_t i;
+
+	for (i = 1; i < RSANUMLIMBS; ++i) {
+		A = (uint128_t)a * b[i] + c[i] + (uint64_t)(A >> 64);
+		B = (uint128_t)d0 * key_limb(key->n, i) + (uint64_t)A +
+		    (uint64_t)(B >> 64);
+		c[i - 1] = (uint64_t)B;
+	}
+
+	A = (A >> 64) + (B >> 64);
+
+	c[i - 1] = (uint64_t)A;
+
+	if (A >> 64)
+		sub_mod64(key, c);
+}
+
+#ifdef CONFIG_RSA_EXPONENT_3
+/**
+ * Montgomery c[] += 0 * b[] / R % mod
+ */
+static void mont_mul_add_0_64(const struct rsa_public_key *key,
+			      uint64_t n0inv, uint64_t *c)
+{
+	uint64_t d0 = c[0] * n0inv;
+	uint128_t B = (uint128_t)d0 * key_limb(key->n, 0) + c[0];
+	uint32_t i;
+
+	for (i = 1; i < RSANUMLIMBS; ++i) {
+		B = (uint128_t)d0 * key_limb(key->n, i) + c[i] +
+		    (uint64_t)(B >> 64);
+		c[i - 1] = (uint64_t)B;
+	}
+
+	c[i - 1] = B >> 64;
+}
+
+/* Montgomery c[] = a[] * 1 / R % key. */
+static void mont_mul_1_64(const struct rsa_public_key *key, uint64_t n0inv,
+			  uint64_t *c, const uint64_t *a)
+{
+	int i;
+
+	for (i = 0; i < RSANUMLIMBS; ++i)
+		c[i] = 0;
+
+	mont_mul_add64(key, n0inv, c, 1, a);
+	for (i = 1; i < RSANUMLIMBS; ++i)
+		mont_mul_add_0_64(key, n0inv, c);
+}
+#endif
+
+/**
+ * Montgomery c[] = a[] * b[] / R % mod
+ */
+static void mont_mul64(const struct rsa_public_key *key, uint64_t n0inv,
+		       uint64_t *c, const uint64_t *a, const uint64_t *b)
+{
+	uint32_t i;
+
+	for (i = 0; i < RSANUMLIMBS; ++i)
+		c[i] = 0;
+
+	for (i = 0; i < RSANUMLIMBS; ++i)
+		mont_mul_add64(key, n0inv, c, a[i], b);
+}
+
+/**
+ * In-place public exponentiation, on 64-bit limbs.
+ *
+ * @param key		Key to use in signing
+ * @param inout		Input and output big-endian byte array
+ * @param workbuf64	Work buffer, 3 x RSANUMLIMBS elements long.
+ */
+static void mod_pow64(const struct rsa_public_key *key, uint8_t *inout,
+		      uint64_t *workbuf64)
+{
+	uint64_t *a = workbuf64;
+	uint64_t *a_r = a + RSANUMLIMBS;
+	uint64_t *aa_r = a_r + RSANUMLIMBS;
+	uint64_t *aaa = aa_r;  /* Re-use location. */
+	uint64_t n0inv = get_n0inv64(key);
+	int i, j;
+
+	/* Convert from big endian byte array to little endian limb array. */
+	for (i = 0; i < RSANUMLIMBS; ++i) {
+		const uint8_t *p = inout + (RSANUMLIMBS - 1 - i) * 8;
+		uint64_t tmp = 0;
+
+		for (j = 0; j < 8; ++j)
+			tmp = (tmp << 8) | p[j];
+		a[i] = tmp;
+	}
+
+	/* aa_r is free until the first squaring; use it to hold RR. */
+	for (i = 0; i < RSANUMLIMBS; ++i)
+		aa_r[i] = key_limb(key->rr, i);
+	mont_mul64(key, n0inv, a_r, a, aa_r);  /* a_r = a * RR / R mod M */
+#ifdef CONFIG_RSA_EXPONENT_3
+	mont_mul64(key, n0inv, aa_r, a_r, a_r);
+	mont_mul64(key, n0inv, a, aa_r, a_r);
+	mont_mul_1_64(key, n0inv, aaa, a);
+#else
+	/* Exponent 65537 */
+	for (i = 0; i < 16; i += 2) {
+		mont_mul64(key, n0inv, aa_r, a_r, a_r);
+		mont_mul64(key, n0inv, a_r, aa_r, aa_r);
+	}
+	mont_mul64(key, n0inv, aaa, a_r, a);  /* aaa = a_r * a / R mod M */
+#endif
+
+	/* Make sure aaa < mod; aaa is at most 1x mod too large. */
+	if (ge_mod64(key, aaa))
+		sub_mod64(key, aaa);
+
+	/* Convert to bigendian byte array */
+	for (i = RSANUMLIMBS - 1; i >= 0; --i) {
+		uint64_t tmp = aaa[i];
+
+		for (j = 56; j >= 0; j -= 8)
+			*inout++ = (uint8_t)(tmp >> j);
+	}
+}
+
+#endif /* CONFIG_RSA_64BIT_LIMBS */
+
 /*
  * PKCS#1 padding (from the RSA PKCS#1 v2.1 standard)
  *
@@ -234,7 +443,8 @@ static int check_padding(const uint8_t *sig)
  * @param signature     RSA signature
  * @param sha           SHA-256 digest of the content to verify
  * @param workbuf32     Work buffer; caller must verify this is
- *                      3 x RSANUMWORDS elements long.
+ *                      3 x RSANUMWORDS elements long, and 8-byte aligned
+ *                      with CONFIG_RSA_64BIT_LIMBS.
  * @return 0 on failure, 1 on success.
  */
 int rsa_verify(const struct rsa_public_key *key, const uint8_t *signature,
@@ -245,7 +455,13 @@ int rsa_verify(const struct rsa_public_key *key, const uint8_t *signature,
 	/* Copy input to local workspace. */
 	memcpy(buf, signature, RSANUMBYTES);
 
+#ifdef CONFIG_RSA_64BIT_LIMBS
+	/* The 64-bit path needs an 8-byte aligned work buffer. */
+	ASSERT(!((uintptr_t)workbuf32 & (sizeof(uint64_t) - 1)));
+	mod_pow64(key, buf, (uint64_t *)workbuf32);
+#else
 	mod_pow(key, buf, workbuf32); /* In-place exponentiation. */
+#endif
 
 	/* Check the PKCS#1 padding */
 	if (check_padding(buf) != 0)
@@ -18,6 +18,7 @@
 #include "shared_mem.h"
 #include "system.h"
 #include "task.h"
+#include "timer.h"
 #include "usb_pd.h"
 #include "util.h"
 #include "vb21_struct.h"
@@ -28,6 +29,10 @@
 #define CPRINTF(format, args...) cprintf(CC_SYSTEM, format, ## args)
 #define CPRINTS(format, args...) cprints(CC_SYSTEM, format, ## args)
 
+/* Duration of the last RW signature check, and of its RSA verify step */
+static uint32_t rwsig_verify_time_us;
+static uint32_t rwsig_rsa_time_us;
+
 #if !defined(CONFIG_MAPPED_STORAGE)
 #error rwsig implementation assumes mem-mapped storage.
 #endif
@@ -102,6 +107,8 @@ int rwsig_check_signature(void)
 	const uint8_t *rwdata = (uint8_t *)CONFIG_PROGRAM_MEMORY_BASE
 					+ CONFIG_RW_MEM_OFF;
 	int good = 0;
+	timestamp_t start = get_time();
+	timestamp_t rsa_start;
 
 	unsigned int rwlen;
 #ifdef CONFIG_RWSIG_TYPE_RWSIG
@@ -190,7 +197,9 @@ int rwsig_check_signature(void)
 	SHA256_update(&ctx, rwdata, rwlen);
 	hash = SHA256_final(&ctx);
 
+	rsa_start = get_time();
 	good = rsa_verify(key, sig, hash, rsa_workbuf);
+	rwsig_rsa_time_us = get_time().val - rsa_start.val;
 	if (!good)
 		goto out;
 
@@ -227,7 +236,9 @@ int rwsig_check_signature(void)
 	}
 #endif
 out:
-	CPRINTS("RW verify %s", good ? "OK" : "FAILED");
+	rwsig_verify_time_us = get_time().val - start.val;
+	CPRINTS("RW verify %s (%d us)", good ? "OK" : "FAILED",
+		rwsig_verify_time_us);
 
 	if (!good) {
 		pd_log_event(PD_EVENT_ACC_RW_FAIL, 0, 0, NULL);
@@ -241,6 +252,11 @@ out:
 	return good;
 }
 
+uint32_t rwsig_get_verify_time(void)
+{
+	return rwsig_verify_time_us;
+}
+
 #ifdef HAS_TASK_RWSIG
 #define TASK_EVENT_ABORT TASK_EVENT_CUSTOM_BIT(0)
 #define TASK_EVENT_CONTINUE TASK_EVENT_CUSTOM_BIT(1)
@@ -321,15 +337,45 @@ DECLARE_HOST_COMMAND(EC_CMD_RWSIG_ACTION,
 #else /* !HAS_TASK_RWSIG */
 enum ec_status rwsig_cmd_check_status(struct host_cmd_handler_args *args)
 {
-	struct ec_response_rwsig_check_status *r = args->response;
+	struct ec_response_rwsig_check_status_v1 *r = args->response;
 
 	memset(r, 0, sizeof(*r));
 	r->status = rwsig_check_signature();
-	args->response_size = sizeof(*r);
+
+	if (args->version >= 1) {
+		r->verify_time_us = rwsig_get_verify_time();
+		args->response_size = sizeof(*r);
+	} else {
+		args->response_size =
+			sizeof(struct ec_response_rwsig_check_status);
+	}
 
 	return EC_RES_SUCCESS;
 }
 DECLARE_HOST_COMMAND(EC_CMD_RWSIG_CHECK_STATUS,
 		     rwsig_cmd_check_status,
-		     EC_VER_MASK(0));
+		     EC_VER_MASK(0) | EC_VER_MASK(1));
+#endif
+
+#ifdef CONFIG_CMD_RWSIG
+static int command_rwsig(int argc, char **argv)
+{
+#ifdef HAS_TASK_RWSIG
+	static const char * const status_str[] = {
+		[RWSIG_UNKNOWN] = "unknown",
+		[RWSIG_IN_PROGRESS] = "in progress",
+		[RWSIG_VALID] = "valid",
+		[RWSIG_INVALID] = "invalid",
+		[RWSIG_ABORTED] = "aborted",
+	};
+
+	ccprintf("Status:      %s\n", status_str[rwsig_status]);
 #endif
+	ccprintf("Verify time: %d us\n", rwsig_verify_time_us);
+	ccprintf("RSA time:    %d us\n", rwsig_rsa_time_us);
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(rwsig, command_rwsig,
+			NULL,
+			"Print RW signature verification status and timing");
+#endif /* CONFIG_CMD_RWSIG */
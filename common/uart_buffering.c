@@ -54,6 +54,60 @@ static int tx_last_snapshot_head;
 static int tx_next_snapshot_head;
 static int tx_checksum __preserved_logs(tx_checksum);
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+BUILD_ASSERT(POWER_OF_TWO(CONFIG_CONSOLE_TOKENIZED_LOG_SIZE));
+
+/* Largest tokenized log record, including the header */
+#define TOK_RECORD_MAX 96
+/* A record must always fit, even in an otherwise empty log */
+BUILD_ASSERT(CONFIG_CONSOLE_TOKENIZED_LOG_SIZE >= TOK_RECORD_MAX);
+#define TOK_BUF_MASK (CONFIG_CONSOLE_TOKENIZED_LOG_SIZE - 1)
+
+/*
+ * Tokenized log buffer.  The head and tail count bytes and are only masked
+ * when indexing, so tok_head - tok_tail is the space used.  Records are
+ * always whole from tok_tail on; the oldest are dropped to make room.
+ */
+test_export_static uint8_t tok_buf[CONFIG_CONSOLE_TOKENIZED_LOG_SIZE]
+			__preserved_logs(tok_buf);
+test_export_static uint32_t tok_head __preserved_logs(tok_head);
+test_export_static uint32_t tok_tail __preserved_logs(tok_tail);
+test_export_static uint32_t tok_checksum __preserved_logs(tok_checksum);
+static uint32_t tok_snapshot_head;
+static uint32_t tok_snapshot_tail;
+
+/* Returns true if <size> is a possible record size */
+static int tok_size_valid(int size)
+{
+	return size >= sizeof(struct ec_console_token_record) &&
+	       size <= TOK_RECORD_MAX;
+}
+
+/*
+ * Returns true if the preserved log is made of whole records from tok_tail to
+ * tok_head.  It may have been written by an image with a different record
+ * layout, or be corrupt.
+ */
+static int tok_buf_valid(void)
+{
+	uint32_t pos;
+
+	if (tok_checksum != (tok_head ^ tok_tail) ||
+	    tok_head - tok_tail > CONFIG_CONSOLE_TOKENIZED_LOG_SIZE)
+		return 0;
+
+	for (pos = tok_tail; pos != tok_head;) {
+		int size = tok_buf[pos & TOK_BUF_MASK];
+
+		if (!tok_size_valid(size) || tok_head - pos < size)
+			return 0;
+		pos += size;
+	}
+
+	return 1;
+}
+#endif
+
 static int uart_buffer_calc_checksum(void)
 {
 	return tx_buf_head ^ tx_buf_tail;
@@ -69,6 +123,14 @@ void uart_init_buffer(void)
 		tx_buf_tail = 0;
 		tx_checksum = 0;
 	}
+
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+	if (!tok_buf_valid()) {
+		tok_head = 0;
+		tok_tail = 0;
+		tok_checksum = 0;
+	}
+#endif
 }
 
 /**
@@ -126,6 +188,87 @@ static int __tx_char(void *context, int c)
 	return __tx_char_raw(context, c);
 }
 
+/**
+ * Put a run of characters into the transmit buffer.
+ *
+ * Copies as much of the run as fits with at most two memcpy()s around the
+ * end of the buffer, and updates the snapshot heads and the preserved log
+ * checksum once for the whole run, with the same result as a sequence of
+ * __tx_char_raw() calls.
+ *
+ * Does not enable the transmit interrupt; assumes that happens elsewhere.
+ *
+ * @param s		Characters to write.
+ * @param len		Number of characters.
+ * @return 0 if all characters were transmitted, 1 if any were dropped.
+ */
+static int __tx_span_raw(const char *s, int len)
+{
+#if defined CONFIG_POLLING_UART
+	while (len--)
+		uart_write_char(*s++);
+#else
+	int head = tx_buf_head;
+	int n, first, d;
+	int tx_buf_new_head, tx_buf_new_tail;
+
+	n = MIN(len, CONFIG_UART_TX_BUF_SIZE - 1 -
+		     TX_BUF_DIFF(head, tx_buf_tail));
+	if (n <= 0)
+		return len > 0;
+
+	/*
+	 * Same rules as __tx_char_raw(): a snapshot head which the new
+	 * characters run over is pushed just ahead of the new head.  The last
+	 * snapshot head stops moving if it catches up with the snapshot head.
+	 */
+	tx_buf_new_head = (head + n) & (CONFIG_UART_TX_BUF_SIZE - 1);
+	tx_buf_new_tail = TX_BUF_NEXT(tx_buf_new_head);
+	d = TX_BUF_DIFF(tx_last_snapshot_head, head);
+	if (d >= 1 && d <= n && tx_last_snapshot_head != tx_snapshot_head) {
+		int snap = TX_BUF_DIFF(tx_snapshot_head, head);
+
+		tx_last_snapshot_head = (snap > d && snap <= n + 1) ?
+			tx_snapshot_head : tx_buf_new_tail;
+	}
+	d = TX_BUF_DIFF(tx_next_snapshot_head, head);
+	if (d >= 1 && d <= n)
+		tx_next_snapshot_head = tx_buf_new_tail;
+
+	first = MIN(n, CONFIG_UART_TX_BUF_SIZE - head);
+	memcpy((char *)tx_buf + head, s, first);
+	memcpy((char *)tx_buf, s + first, n - first);
+	tx_buf_head = tx_buf_new_head;
+
+	if (IS_ENABLED(CONFIG_PRESERVE_LOGS))
+		tx_checksum = uart_buffer_calc_checksum();
+
+	if (n < len)
+		return 1;
+#endif
+	return 0;
+}
+
+static int __tx_span(void *context, const char *s, int len)
+{
+	while (len > 0) {
+		const char *nl = memchr(s, '\n', len);
+		int run = nl ? nl - s : len;
+
+		if (run && __tx_span_raw(s, run))
+			return 1;
+		if (!nl)
+			break;
+
+		/* Translate '\n' to '\r\n' */
+		if (__tx_span_raw("\r\n", 2))
+			return 1;
+		s += run + 1;
+		len -= run + 1;
+	}
+	return 0;
+}
+
 #ifdef CONFIG_UART_TX_DMA
 
 /**
@@ -276,49 +419,34 @@ int uart_putc(int c)
 
 int uart_puts(const char *outstr)
 {
-	/* Put all characters in the output buffer */
-	while (*outstr) {
-		if (__tx_char(NULL, *outstr++) != 0)
-			break;
-	}
-
-	uart_tx_start();
-
-	/* Successful if we consumed all output */
-	return *outstr ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return uart_put(outstr, strlen(outstr));
 }
 
 int uart_put(const char *out, int len)
 {
 	/* Put all characters in the output buffer */
-	while (len--) {
-		if (__tx_char(NULL, *out++) != 0)
-			break;
-	}
+	int rv = __tx_span(NULL, out, len);
 
 	uart_tx_start();
 
 	/* Successful if we consumed all output */
-	return len ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_put_raw(const char *out, int len)
 {
 	/* Put all characters in the output buffer */
-	while (len--) {
-		if (__tx_char_raw(NULL, *out++) != 0)
-			break;
-	}
+	int rv = __tx_span_raw(out, len);
 
 	uart_tx_start();
 
 	/* Successful if we consumed all output */
-	return len ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_vprintf(const char *format, va_list args)
 {
-	int rv = vfnprintf(__tx_char, NULL, format, args);
+	int rv = vfnprintf_span(__tx_char, __tx_span, NULL, format, args);
 
 	uart_tx_start();
 
@@ -402,6 +530,225 @@ static void uart_rx_dma_init(void)
 DECLARE_HOOK(HOOK_INIT, uart_rx_dma_init, HOOK_PRIO_DEFAULT);
 #endif
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+/*****************************************************************************/
+/* Tokenized log */
+
+/**
+ * Append to a record being built, if it fits.
+ *
+ * @return New size of the record, or -1 if it does not fit.
+ */
+static int tok_put(uint8_t *rec, int pos, const void *data, int len)
+{
+	if (pos < 0 || pos + len > TOK_RECORD_MAX)
+		return -1;
+	memcpy(rec + pos, data, len);
+	return pos + len;
+}
+
+/**
+ * Pack the arguments for a format string, as described for
+ * struct ec_console_token_record.
+ *
+ * @param rec		Record being built
+ * @param pos		Size of the record so far
+ * @param format	Format string
+ * @param args		Parameters
+ * @param dropped	Set non-zero if some arguments did not fit
+ * @return Size of the record.
+ */
+static int tok_pack_args(uint8_t *rec, int pos, const char *format,
+			 va_list args, int *dropped)
+{
+	uint32_t v32;
+	uint64_t v64;
+	int next = pos;
+
+	for (; *format; pos = next) {
+		int is_64 = 0;
+
+		if (*format++ != '%')
+			continue;
+
+		/* Flags, width and precision; only '*' takes an argument */
+		while (isdigit(*format) || *format == '-' || *format == '+' ||
+		       *format == '.' || *format == '*') {
+			if (*format++ == '*') {
+				v32 = va_arg(args, int);
+				next = tok_put(rec, next, &v32, sizeof(v32));
+			}
+		}
+
+		if (*format == 'l') {
+			is_64 = sizeof(long) == sizeof(uint64_t);
+			if (*++format == 'l') {
+				is_64 = 1;
+				format++;
+			}
+		} else if (*format == 'z') {
+			is_64 = sizeof(size_t) == sizeof(uint64_t);
+			format++;
+		}
+
+		switch (*format) {
+		case '\0':
+		case '%':
+			break;
+		case 's': {
+			const char *str = va_arg(args, const char *);
+			int len, room = TOK_RECORD_MAX - next - 1;
+
+			if (!str)
+				str = "(NULL)";
+			len = next < 0 || room < 0 ? 0 : strnlen(str, room);
+			next = tok_put(rec, next, str, len);
+			next = tok_put(rec, next, "", 1);
+			break;
+		}
+		case 'p': {
+			const void *ptr = va_arg(args, const void *);
+
+			format++;
+			if (*format == 'T') {
+				if (ptr == PRINTF_TIMESTAMP_NOW)
+					v64 = get_time().val;
+				else
+					v64 = *(const uint64_t *)ptr;
+				next = tok_put(rec, next, &v64, sizeof(v64));
+			} else if (*format == 'h') {
+				const struct hex_buffer_params *hex = ptr;
+				uint8_t len = 0;
+
+				if (hex && next >= 0)
+					len = MIN(hex->size,
+						  TOK_RECORD_MAX - next - 1);
+				next = tok_put(rec, next, &len, 1);
+				if (len)
+					next = tok_put(rec, next, hex->buffer,
+						       len);
+			} else if (*format == 'b') {
+				const struct binary_print_params *bin = ptr;
+				uint8_t count = bin ? bin->count : 0;
+
+				v32 = bin ? bin->value : 0;
+				next = tok_put(rec, next, &v32, sizeof(v32));
+				next = tok_put(rec, next, &count, 1);
+			} else {
+				v32 = (uintptr_t)ptr;
+				next = tok_put(rec, next, &v32, sizeof(v32));
+			}
+			break;
+		}
+		default:
+			if (is_64) {
+				v64 = va_arg(args, uint64_t);
+				next = tok_put(rec, next, &v64, sizeof(v64));
+			} else {
+				v32 = va_arg(args, uint32_t);
+				next = tok_put(rec, next, &v32, sizeof(v32));
+			}
+		}
+		if (next < 0)
+			break;
+		if (*format)
+			format++;
+	}
+
+	*dropped = next < 0;
+	return next < 0 ? pos : next;
+}
+
+static void tok_copy_in(uint32_t pos, const uint8_t *src, int len)
+{
+	int i = pos & TOK_BUF_MASK;
+	int first = MIN(len, CONFIG_CONSOLE_TOKENIZED_LOG_SIZE - i);
+
+	memcpy(tok_buf + i, src, first);
+	memcpy(tok_buf, src + first, len - first);
+}
+
+static void tok_copy_out(uint8_t *dst, uint32_t pos, int len)
+{
+	int i = pos & TOK_BUF_MASK;
+	int first = MIN(len, CONFIG_CONSOLE_TOKENIZED_LOG_SIZE - i);
+
+	memcpy(dst, tok_buf + i, first);
+	memcpy(dst + first, tok_buf, len - first);
+}
+
+int uart_log_tokens(int channel, const char *format, va_list args)
+{
+	uint8_t rec[TOK_RECORD_MAX];
+	struct ec_console_token_record *r = (void *)rec;
+	int size, dropped;
+
+	if (format < __log_fmts || format >= __log_fmts_end ||
+	    format - __log_fmts > UINT16_MAX)
+		return EC_ERROR_INVAL;
+
+	size = tok_pack_args(rec, sizeof(*r), format, args, &dropped);
+	r->size = size;
+	r->channel = channel;
+	r->fmt = format - __log_fmts;
+	r->time_ms = get_time().val / 1000;
+
+	interrupt_disable();
+	/* Drop the oldest records to make room */
+	while (tok_head - tok_tail + size > CONFIG_CONSOLE_TOKENIZED_LOG_SIZE) {
+		int old = tok_buf[tok_tail & TOK_BUF_MASK];
+
+		/* The log is corrupt; drop all of it */
+		if (!tok_size_valid(old))
+			old = tok_head - tok_tail;
+		tok_tail += old;
+	}
+	tok_copy_in(tok_head, rec, size);
+	tok_head += size;
+	if (IS_ENABLED(CONFIG_PRESERVE_LOGS))
+		tok_checksum = tok_head ^ tok_tail;
+	interrupt_enable();
+
+	return dropped ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+}
+
+/* Copy whole records from the snapshot, for CONSOLE_READ_TOKENS */
+static int tok_read(uint8_t *dest, uint16_t dest_size, uint16_t *write_count)
+{
+	while (1) {
+		int size;
+
+		interrupt_disable();
+		/* Skip records which were dropped since the snapshot */
+		if ((int32_t)(tok_tail - tok_snapshot_tail) > 0)
+			tok_snapshot_tail = tok_tail;
+		if ((int32_t)(tok_snapshot_head - tok_snapshot_tail) <= 0) {
+			interrupt_enable();
+			break;
+		}
+		size = tok_buf[tok_snapshot_tail & TOK_BUF_MASK];
+		if (!tok_size_valid(size) ||
+		    tok_snapshot_head - tok_snapshot_tail < size) {
+			/* The log is corrupt; skip the rest of the snapshot */
+			tok_snapshot_tail = tok_snapshot_head;
+			interrupt_enable();
+			break;
+		}
+		if (*write_count + size > dest_size) {
+			interrupt_enable();
+			break;
+		}
+		tok_copy_out(dest + *write_count, tok_snapshot_tail, size);
+		tok_snapshot_tail += size;
+		interrupt_enable();
+
+		*write_count += size;
+	}
+
+	return EC_RES_SUCCESS;
+}
+#endif /* CONFIG_CONSOLE_TOKENIZED_LOG */
+
 /*****************************************************************************/
 /* Host commands */
 
@@ -460,6 +807,13 @@ enum ec_status uart_console_read_buffer_init(void)
 	tx_last_snapshot_head = tx_next_snapshot_head;
 	tx_next_snapshot_head = tx_buf_head;
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+	interrupt_disable();
+	tok_snapshot_head = tok_head;
+	tok_snapshot_tail = tok_tail;
+	interrupt_enable();
+#endif
+
 	/*
 	 * Immediately skip any unused bytes.  This doesn't always work,
 	 * because a higher-priority task or interrupt handler can write to the
@@ -493,6 +847,10 @@ int uart_console_read_buffer(uint8_t type,
 	case CONSOLE_READ_RECENT:
 		tail = &tx_last_snapshot_head;
 		break;
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+	case CONSOLE_READ_TOKENS:
+		return tok_read((uint8_t *)dest, dest_size, write_count);
+#endif
 	default:
 		return EC_RES_INVALID_PARAM;
 	}
@@ -162,6 +162,56 @@ static int __tx_char(void *context, int c)
 #endif
 }
 
+/*
+ * Queue a string like __tx_char() does each of its characters, but writing
+ * straight into the free space of tx_q and advancing its tail once per pass.
+ */
+static int __tx_string(const char *s)
+{
+	struct queue_chunk chunks[2];
+	int cr_sent = 0;
+	uint8_t c;
+	size_t n;
+	int i;
+
+	while (*s) {
+		if (!queue_get_write_chunks(&tx_q, chunks)) {
+#ifdef CONFIG_USB_CONSOLE_CRC
+			usleep(500);
+			continue;
+#else
+			return EC_ERROR_OVERFLOW;
+#endif
+		}
+
+		n = 0;
+		for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+			uint8_t *buffer = chunks[i].buffer;
+			size_t j;
+
+			for (j = 0; j < chunks[i].count && *s; j++) {
+				/* Send "\r\n" for "\n" */
+				if (*s == '\n' && !cr_sent) {
+					c = '\r';
+					cr_sent = 1;
+				} else {
+					c = *s++;
+					cr_sent = 0;
+				}
+#ifdef CONFIG_USB_CONSOLE_CRC
+				crc32_ctx_hash8(&usb_tx_crc_ctx, c);
+#endif
+				buffer[j] = c;
+			}
+			n += j;
+		}
+
+		queue_advance_tail(&tx_q, n);
+	}
+
+	return EC_SUCCESS;
+}
+
 /*
  * Public USB console implementation below.
  */
@@ -189,11 +239,7 @@ int usb_puts(const char *outstr)
 	if (ret)
 		return ret;
 
-	while (*outstr) {
-		ret = __tx_char(NULL, *outstr++);
-		if (ret)
-			break;
-	}
+	ret = __tx_string(outstr);
 	handle_output();
 
 	return ret;
@@ -1111,6 +1111,72 @@ static bool pe_can_send_sop_vdm(int port, int vdm_cmd)
 	return false;
 }
 
+/*
+ * Returns true if a Ready state could start a discovery once the discovery
+ * timer expires.  This mirrors the checks in common_src_snk_dpm_requests().
+ */
+static bool pe_discovery_pending(int port)
+{
+	if (!IS_ENABLED(CONFIG_USB_PD_ALT_MODE_DFP) ||
+			PE_CHK_FLAG(port, PE_FLAGS_VDM_SETUP_DONE))
+		return false;
+
+	if (pe_can_send_sop_prime(port) &&
+	    (pd_get_identity_discovery(port, TCPC_TX_SOP_PRIME) ==
+				PD_DISC_NEEDED ||
+	     pd_get_svids_discovery(port, TCPC_TX_SOP_PRIME) ==
+				PD_DISC_NEEDED ||
+	     pd_get_modes_discovery(port, TCPC_TX_SOP_PRIME) ==
+				PD_DISC_NEEDED))
+		return true;
+
+	return (pd_get_identity_discovery(port, TCPC_TX_SOP) ==
+				PD_DISC_NEEDED &&
+			pe_can_send_sop_vdm(port, CMD_DISCOVER_IDENT)) ||
+		(pd_get_svids_discovery(port, TCPC_TX_SOP) == PD_DISC_NEEDED &&
+			pe_can_send_sop_vdm(port, CMD_DISCOVER_SVID)) ||
+		(pd_get_modes_discovery(port, TCPC_TX_SOP) == PD_DISC_NEEDED &&
+			pe_can_send_sop_vdm(port, CMD_DISCOVER_MODES));
+}
+
+uint64_t pe_get_next_deadline(int port)
+{
+	const enum usb_pe_state state = get_state_pe(port);
+	uint64_t next = SM_DEADLINE_NONE;
+
+	if (local_state[port] != SM_RUN)
+		return SM_DEADLINE_NONE;
+
+	/*
+	 * Only the Ready states are known to wait purely on timers and
+	 * events; every other state keeps being polled.
+	 */
+	if (state != PE_SRC_READY && state != PE_SNK_READY)
+		return SM_DEADLINE_POLL;
+
+	if (pe[port].dpm_request ||
+	    PE_CHK_FLAG(port, PE_FLAGS_MSG_RECEIVED |
+			      PE_FLAGS_VDM_REQUEST_CONTINUE))
+		return SM_DEADLINE_POLL;
+
+	next = MIN(next, pe[port].wait_and_add_jitter_timer);
+
+	if (state == PE_SNK_READY)
+		next = MIN(next, pe[port].sink_request_timer);
+
+	if (PE_CHK_FLAG(port, PE_FLAGS_WAITING_PR_SWAP))
+		next = MIN(next, pe[port].pr_swap_wait_timer);
+
+	if (pe_discovery_pending(port))
+		next = MIN(next, pe[port].discover_identity_timer);
+
+	/* A timer that already expired is waiting on something else */
+	if (next <= get_time().val)
+		return SM_DEADLINE_POLL;
+
+	return next;
+}
+
 static void pe_send_soft_reset(const int port, enum tcpm_transmit_type type)
 {
 	pe[port].soft_reset_sop = type;
@@ -1205,6 +1271,10 @@ void pe_got_soft_reset(int port)
 void pd_dpm_request(int port, enum pd_dpm_request req)
 {
 	PE_SET_DPM_REQUEST(port, req);
+
+	/* A tickless PD task won't poll for the request */
+	if (IS_ENABLED(CONFIG_USB_PD_TICKLESS))
+		task_wake(PD_PORT_TO_TASK_ID(port));
 }
 
 void pe_vconn_swap_complete(int port)
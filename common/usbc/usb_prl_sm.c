@@ -697,6 +697,28 @@ void prl_run(int port, int evt, int en)
 	}
 }
 
+uint64_t prl_get_next_deadline(int port)
+{
+	if (local_state[port] != SM_RUN)
+		return SM_DEADLINE_NONE;
+
+	/*
+	 * Received messages and hard resets arrive as task events, so the
+	 * layer only needs polling while a transmission or a hard reset is
+	 * in flight, or while messages are still queued since only one is
+	 * taken per run.
+	 */
+	if (tcpm_has_pending_message(port) ||
+	    prl_tx_get_state(port) != PRL_TX_WAIT_FOR_MESSAGE_REQUEST ||
+	    prl_hr_get_state(port) != PRL_HR_WAIT_FOR_REQUEST ||
+	    prl_is_busy(port) ||
+	    PRL_TX_CHK_FLAG(port, PRL_FLAGS_MSG_XMIT) ||
+	    TCH_CHK_FLAG(port, PRL_FLAGS_MSG_XMIT))
+		return SM_DEADLINE_POLL;
+
+	return SM_DEADLINE_NONE;
+}
+
 void prl_set_rev(int port, enum tcpm_transmit_type type,
 						enum pd_rev_type rev)
 {
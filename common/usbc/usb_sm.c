@@ -29,34 +29,51 @@ struct internal_ctx {
 BUILD_ASSERT(sizeof(struct internal_ctx) ==
 	     member_size(struct sm_ctx, internal));
 
-/* Gets the first shared parent state between a and b (inclusive) */
+/* Gets the number of parents above state s */
+static int state_depth(usb_state_ptr s)
+{
+	int depth = 0;
+
+	/* This assumes that s is NULL terminated without cycles */
+	while (s != NULL && s->parent != NULL) {
+		s = s->parent;
+		++depth;
+	}
+
+	return depth;
+}
+
+/*
+ * Gets the first shared parent state between a and b (inclusive). Both
+ * chains are first brought to the same depth, after which the shared parent
+ * is where they meet, so this is linear rather than quadratic in the depth.
+ */
 static usb_state_ptr shared_parent_state(usb_state_ptr a, usb_state_ptr b)
 {
-	const usb_state_ptr orig_b = b;
+	int depth_a, depth_b;
 
 	/* There are no common ancestors */
-	if (b == NULL)
+	if (a == NULL || b == NULL)
 		return NULL;
 
-	/* This assumes that both A and B are NULL terminated without cycles */
-	while (a != NULL) {
-		/* We found a match return */
-		if (a == b)
-			return a;
-
-		/*
-		 * Otherwise, increment b down the list for comparison until we
-		 * run out, then increment a and start over on b for comparison
-		 */
-		if (b->parent == NULL) {
-			a = a->parent;
-			b = orig_b;
-		} else {
-			b = b->parent;
-		}
+	/* Transitions between siblings are the common case */
+	if (a->parent == b->parent)
+		return a == b ? a : a->parent;
+
+	depth_a = state_depth(a);
+	depth_b = state_depth(b);
+
+	for (; depth_a > depth_b; --depth_a)
+		a = a->parent;
+	for (; depth_b > depth_a; --depth_b)
+		b = b->parent;
+
+	while (a != b) {
+		a = a->parent;
+		b = b->parent;
 	}
 
-	return NULL;
+	return a;
 }
 
 /*
@@ -3456,6 +3456,40 @@ void tc_run(const int port)
 	run_state(port, &tc[port].ctx);
 }
 
+uint64_t tc_get_next_deadline(int port)
+{
+	const enum usb_tc_state state = get_state_tc(port);
+	uint64_t next = SM_DEADLINE_NONE;
+
+	/*
+	 * Only the Attached states are known to wait purely on timers and
+	 * CC/Vbus events; every other state keeps being polled.
+	 */
+	if (state != TC_ATTACHED_SNK && state != TC_ATTACHED_SRC)
+		return SM_DEADLINE_POLL;
+
+	if (TC_CHK_FLAG(port, TC_FLAGS_HARD_RESET_REQUESTED |
+			      TC_FLAGS_REQUEST_PR_SWAP |
+			      TC_FLAGS_REQUEST_DR_SWAP |
+			      TC_FLAGS_REQUEST_VC_SWAP_ON |
+			      TC_FLAGS_REQUEST_VC_SWAP_OFF |
+			      TC_FLAGS_PR_SWAP_IN_PROGRESS |
+			      TC_FLAGS_SUSPEND))
+		return SM_DEADLINE_POLL;
+
+	/* Rp value change debounce, and delayed PD enable as a source */
+	if (state == TC_ATTACHED_SNK && tc[port].cc_debounce)
+		next = tc[port].cc_debounce;
+	else if (state == TC_ATTACHED_SRC && tc[port].timeout)
+		next = tc[port].timeout;
+
+	/* A timer that already expired is waiting on something else */
+	if (next <= get_time().val)
+		return SM_DEADLINE_POLL;
+
+	return next;
+}
+
 static void pd_chipset_resume(void)
 {
 	int i;
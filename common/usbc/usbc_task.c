@@ -73,13 +73,47 @@ static void pd_task_init(int port)
 		schedule_deferred_pd_interrupt(port);
 }
 
+/*
+ * Returns how long the task may wait for an event before one of the port's
+ * state machines needs to run again.
+ */
+static int pd_task_timeout(int port)
+{
+	uint64_t next = SM_DEADLINE_NONE;
+	uint64_t now;
+
+	if (paused[port])
+		return -1;
+
+	if (!IS_ENABLED(CONFIG_USB_PD_TICKLESS))
+		return USBC_EVENT_TIMEOUT;
+
+	if (IS_ENABLED(CONFIG_USB_TYPEC_SM))
+		next = MIN(next, tc_get_next_deadline(port));
+
+	if (IS_ENABLED(CONFIG_USB_PE_SM))
+		next = MIN(next, pe_get_next_deadline(port));
+
+	if (IS_ENABLED(CONFIG_USB_PRL_SM))
+		next = MIN(next, prl_get_next_deadline(port));
+
+	now = get_time().val;
+	if (next <= now)
+		return USBC_EVENT_TIMEOUT;
+
+	/*
+	 * Timers expire once the time is past the deadline. Conditions that
+	 * are polled rather than signalled by an event are still checked
+	 * every CONFIG_USB_PD_TICKLESS_MAX_SLEEP.
+	 */
+	return MIN(next - now + 1,
+		   (uint64_t)CONFIG_USB_PD_TICKLESS_MAX_SLEEP);
+}
+
 static bool pd_task_loop(int port)
 {
 	/* wait for next event/packet or timeout expiration */
-	const uint32_t evt =
-		task_wait_event(paused[port]
-					? -1
-					: USBC_EVENT_TIMEOUT);
+	const uint32_t evt = task_wait_event(pd_task_timeout(port));
 
 	/*
 	 * Re-use TASK_EVENT_RESET_DONE in tests to restart the USB task
@@ -33,11 +33,19 @@ struct vboot_hash_tag {
 #define VBOOT_HASH_SYSJUMP_TAG 0x5648 /* "VH" */
 #define VBOOT_HASH_SYSJUMP_VERSION 1
 
-#define CHUNK_SIZE 1024       /* Bytes to hash per deferred call */
+#define CHUNK_SIZE CONFIG_VBOOT_HASH_CHUNK_SIZE /* Bytes to hash per step */
+/* Bytes to hash per deferred call */
+#define WINDOW_SIZE (CHUNK_SIZE * CONFIG_VBOOT_HASH_CHUNKS_PER_CALL)
 #define WORK_INTERVAL_US 100  /* Delay between deferred calls */
+/* Longest a blocking hash waits for shared memory before giving up */
+#define BUSY_TIMEOUT_US (100 * MSEC)
 
+BUILD_ASSERT(CONFIG_VBOOT_HASH_CHUNKS_PER_CALL >= 1);
+
+#ifndef CONFIG_MAPPED_STORAGE
 /* Check that CHUNK_SIZE fits in shared memory. */
 SHARED_MEM_CHECK_SIZE(CHUNK_SIZE);
+#endif
 
 static uint32_t data_offset;
 static uint32_t data_size;
@@ -45,6 +53,8 @@ static uint32_t curr_pos;
 static const uint8_t *hash;   /* Hash, or NULL if not valid */
 static int want_abort;
 static int in_progress;
+static timestamp_t hash_start_time;
+static uint32_t hash_time_us;  /* Duration of the last completed hash */
 #define VBOOT_HASH_DEFERRED	true
 #define VBOOT_HASH_BLOCKING	false
 
@@ -75,6 +85,16 @@ DECLARE_DEFERRED(vboot_hash_next_chunk);
 
 #ifndef CONFIG_MAPPED_STORAGE
 
+/**
+ * Read and hash <size> bytes at flash offset <offset>.
+ *
+ * The data is read CHUNK_SIZE bytes at a time into a single shared memory
+ * buffer, which is held for the whole window so back-to-back chunks don't pay
+ * for a shared memory acquire/release each.
+ *
+ * @return EC_SUCCESS, EC_ERROR_BUSY if shared memory is in use, or the error
+ *	   from flash_read().
+ */
 static int read_and_hash_chunk(int offset, int size)
 {
 	char *buf;
@@ -83,22 +103,20 @@ static int read_and_hash_chunk(int offset, int size)
 	if (size == 0)
 		return EC_SUCCESS;
 
-	rv = shared_mem_acquire(size, &buf);
-	if (rv == EC_ERROR_BUSY) {
-		/* Couldn't update hash right now; try again later */
-		hook_call_deferred(&vboot_hash_next_chunk_data,
-				   WORK_INTERVAL_US);
-		return rv;
-	} else if (rv != EC_SUCCESS) {
-		vboot_hash_abort();
+	rv = shared_mem_acquire(MIN(size, CHUNK_SIZE), &buf);
+	if (rv != EC_SUCCESS)
 		return rv;
-	}
 
-	rv = flash_read(offset, size, buf);
-	if (rv == EC_SUCCESS)
-		SHA256_update(&ctx, (const uint8_t *)buf, size);
-	else
-		vboot_hash_abort();
+	while (size > 0) {
+		int len = MIN(size, CHUNK_SIZE);
+
+		rv = flash_read(offset, len, buf);
+		if (rv != EC_SUCCESS)
+			break;
+		SHA256_update(&ctx, (const uint8_t *)buf, len);
+		offset += len;
+		size -= len;
+	}
 
 	shared_mem_release(buf);
 	return rv;
@@ -112,33 +130,67 @@ static int read_and_hash_chunk(int offset, int size)
 #define SHA256_PRINT_SIZE 4
 #endif
 
-static void hash_next_chunk(size_t size)
+/**
+ * Hash the next <size> bytes and advance curr_pos past them on success.
+ */
+static int hash_next_chunk(size_t size)
 {
+	int rv = EC_SUCCESS;
+
 #ifdef CONFIG_MAPPED_STORAGE
 	flash_lock_mapped_storage(1);
 	SHA256_update(&ctx, (const uint8_t *)(CONFIG_MAPPED_STORAGE_BASE +
 					      data_offset + curr_pos), size);
 	flash_lock_mapped_storage(0);
 #else
-	if (read_and_hash_chunk(data_offset + curr_pos, size) != EC_SUCCESS)
-		return;
+	rv = read_and_hash_chunk(data_offset + curr_pos, size);
 #endif
+	if (rv == EC_SUCCESS)
+		curr_pos += size;
+
+	return rv;
 }
 
-static void vboot_hash_all_chunks(void)
+/**
+ * Store the final hash and leave the in-progress state.
+ */
+static void vboot_hash_finish(void)
 {
-	do {
-		size_t size = MIN(CHUNK_SIZE, data_size - curr_pos);
-		hash_next_chunk(size);
-		curr_pos += size;
-	} while (curr_pos < data_size);
-
 	hash = SHA256_final(&ctx);
-	CPRINTS("hash done %ph", HEX_BUF(hash, SHA256_PRINT_SIZE));
+	hash_time_us = get_time().val - hash_start_time.val;
+	CPRINTS("hash done %ph (%d us)", HEX_BUF(hash, SHA256_PRINT_SIZE),
+		hash_time_us);
 	in_progress = 0;
 	clock_enable_module(MODULE_FAST_CPU, 0);
+}
+
+static void vboot_hash_all_chunks(void)
+{
+	timestamp_t deadline;
+
+	deadline.val = get_time().val + BUSY_TIMEOUT_US;
+
+	while (curr_pos < data_size) {
+		size_t size = MIN(WINDOW_SIZE, data_size - curr_pos);
+		int rv = hash_next_chunk(size);
+
+		if (rv == EC_SUCCESS) {
+			/* Progress made; restart the wait for shared memory */
+			deadline.val = get_time().val + BUSY_TIMEOUT_US;
+		} else if (rv == EC_ERROR_BUSY &&
+			   !timestamp_expired(deadline, NULL)) {
+			/* Wait for shared memory to be released */
+			usleep(WORK_INTERVAL_US);
+		} else {
+			CPRINTS("hash failed (%d)", rv);
+			in_progress = 0;
+			clock_enable_module(MODULE_FAST_CPU, 0);
+			vboot_hash_abort();
+			return;
+		}
+	}
 
-	return;
+	vboot_hash_finish();
 }
 
 /**
@@ -147,6 +199,7 @@ static void vboot_hash_all_chunks(void)
 static void vboot_hash_next_chunk(void)
 {
 	int size;
+	int rv;
 
 	/* Handle abort */
 	if (want_abort) {
@@ -156,19 +209,18 @@ static void vboot_hash_next_chunk(void)
 		return;
 	}
 
-	/* Compute the next chunk of hash */
-	size = MIN(CHUNK_SIZE, data_size - curr_pos);
-	hash_next_chunk(size);
+	/* Compute the next window of hash */
+	size = MIN(WINDOW_SIZE, data_size - curr_pos);
+	rv = hash_next_chunk(size);
+	if (rv != EC_SUCCESS && rv != EC_ERROR_BUSY) {
+		/* Read failed; abort on the next call */
+		want_abort = 1;
+		hook_call_deferred(&vboot_hash_next_chunk_data, 0);
+		return;
+	}
 
-	curr_pos += size;
 	if (curr_pos >= data_size) {
-		/* Store the final hash */
-		hash = SHA256_final(&ctx);
-		CPRINTS("hash done %ph", HEX_BUF(hash, SHA256_PRINT_SIZE));
-
-		in_progress = 0;
-
-		clock_enable_module(MODULE_FAST_CPU, 0);
+		vboot_hash_finish();
 
 		/* Handle receiving abort during finalize */
 		if (want_abort)
@@ -177,7 +229,10 @@ static void vboot_hash_next_chunk(void)
 		return;
 	}
 
-	/* If we're still here, more work to do; come back later */
+	/*
+	 * If we're still here, more work to do (or shared memory was busy);
+	 * come back later.
+	 */
 	hook_call_deferred(&vboot_hash_next_chunk_data, WORK_INTERVAL_US);
 }
 
@@ -197,8 +252,9 @@ static void vboot_hash_next_chunk(void)
  * 			False to hash with a blocking single call.
  * @return		ec_error_list.
  */
-static int vboot_hash_start(uint32_t offset, uint32_t size,
-			    const uint8_t *nonce, int nonce_size, bool deferred)
+test_export_static int vboot_hash_start(uint32_t offset, uint32_t size,
+					const uint8_t *nonce, int nonce_size,
+					bool deferred)
 {
 	/* Fail if hash computation is already in progress */
 	if (in_progress)
@@ -221,6 +277,7 @@ static int vboot_hash_start(uint32_t offset, uint32_t size,
 	hash = NULL;
 	want_abort = 0;
 	in_progress = 1;
+	hash_start_time = get_time();
 
 	/* Restart the hash computation */
 	CPRINTS("hash start 0x%08x 0x%08x", offset, size);
@@ -380,6 +437,8 @@ static int command_hash(int argc, char **argv)
 			ccprintf("%ph\n", HEX_BUF(hash, SHA256_DIGEST_SIZE));
 		else
 			ccprintf("(invalid)\n");
+		if (hash && !in_progress)
+			ccprintf("Time:   %d us\n", hash_time_us);
 
 		return EC_SUCCESS;
 	}
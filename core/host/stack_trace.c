@@ -81,6 +81,11 @@ static void __attribute__((noinline)) _task_dump_trace_dispatch(int sig)
 				running, task_get_name(running));
 	}
 
+	/* Coroutine tasks and their ISRs already run on the main thread */
+	if (need_dispatch &&
+	    pthread_equal(task_get_thread(running), main_thread))
+		need_dispatch = 0;
+
 	if (need_dispatch) {
 		pthread_kill(task_get_thread(running), SIGNAL_TRACE_DUMP);
 	} else {
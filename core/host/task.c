@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ucontext.h>
 
 #include "atomic.h"
 #include "common.h"
@@ -23,11 +24,31 @@
 #include "test_util.h"
 #include "timer.h"
 
+/*
+ * ASan and MSan do not follow swapcontext() stack switches, so sanitizer
+ * builds keep one thread per task.
+ */
+#ifdef __SANITIZE_ADDRESS__
+#undef CONFIG_HOST_TASK_COROUTINES
+#endif
+#ifdef __has_feature
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer)
+#undef CONFIG_HOST_TASK_COROUTINES
+#endif
+#endif
+
 #define SIGNAL_INTERRUPT SIGUSR1
 
+/* Same as the default pthread stack, only touched pages are backed */
+#define COROUTINE_STACK_SIZE (8 * 1024 * 1024)
+
 struct emu_task_t {
 	pthread_t thread;
+#ifdef CONFIG_HOST_TASK_COROUTINES
+	ucontext_t context;
+#else
 	pthread_cond_t resume;
+#endif
 	uint32_t event;
 	timestamp_t wake_time;
 	uint8_t started;
@@ -39,8 +60,12 @@ struct task_args {
 };
 
 static struct emu_task_t tasks[TASK_ID_COUNT];
+#ifdef CONFIG_HOST_TASK_COROUTINES
+static ucontext_t scheduler_context;
+#else
 static pthread_cond_t scheduler_cond;
 static pthread_mutex_t run_lock;
+#endif
 static task_id_t running_task_id;
 static int task_started;
 
@@ -54,7 +79,18 @@ static int generator_sleeping;
 static timestamp_t generator_sleep_deadline;
 static int has_interrupt_generator = 1;
 
-/* thread local task id */
+/*
+ * Tasks with a pending timeout, ordered by wake time, then by task ID (lowest
+ * first). Only modified by the scheduler and by the task handing control to
+ * it, so no locking beyond the scheduling handoff is needed.
+ */
+static task_id_t wake_queue[TASK_ID_COUNT];
+static int wake_queue_len;
+
+/*
+ * Thread local task id. With coroutines, all tasks share the scheduler thread
+ * and this is updated on every switch.
+ */
 static __thread task_id_t my_task_id = TASK_ID_INVALID;
 
 static void task_enable_all_tasks_callback(void);
@@ -198,6 +234,69 @@ pthread_t task_get_thread(task_id_t tskid)
 	return tasks[tskid].thread;
 }
 
+static void wake_queue_remove(task_id_t tskid)
+{
+	int i;
+
+	for (i = 0; i < wake_queue_len; i++) {
+		if (wake_queue[i] == tskid) {
+			memmove(wake_queue + i, wake_queue + i + 1,
+				(wake_queue_len - i - 1) * sizeof(wake_queue[0]));
+			wake_queue_len--;
+			return;
+		}
+	}
+}
+
+static void task_set_wake_time(task_id_t tskid, uint64_t wake_time)
+{
+	int i;
+
+	wake_queue_remove(tskid);
+	tasks[tskid].wake_time.val = wake_time;
+	if (wake_time == ~0ull)
+		return;
+
+	/* Insert from the back, new timeouts usually expire last */
+	for (i = wake_queue_len; i > 0; i--) {
+		const struct emu_task_t *prev = tasks + wake_queue[i - 1];
+
+		if (prev->wake_time.val < wake_time ||
+		    (prev->wake_time.val == wake_time &&
+		     wake_queue[i - 1] < tskid))
+			break;
+		wake_queue[i] = wake_queue[i - 1];
+	}
+	wake_queue[i] = tskid;
+	wake_queue_len++;
+}
+
+#ifdef CONFIG_HOST_TASK_COROUTINES
+static void task_switch_to_scheduler(task_id_t tskid)
+{
+	swapcontext(&tasks[tskid].context, &scheduler_context);
+}
+
+static void task_switch_from_scheduler(task_id_t tskid)
+{
+	my_task_id = tskid;
+	swapcontext(&scheduler_context, &tasks[tskid].context);
+	my_task_id = TASK_ID_INVALID;
+}
+#else
+static void task_switch_to_scheduler(task_id_t tskid)
+{
+	pthread_cond_signal(&scheduler_cond);
+	pthread_cond_wait(&tasks[tskid].resume, &run_lock);
+}
+
+static void task_switch_from_scheduler(task_id_t tskid)
+{
+	pthread_cond_signal(&tasks[tskid].resume);
+	pthread_cond_wait(&scheduler_cond, &run_lock);
+}
+#endif
+
 uint32_t task_set_event(task_id_t tskid, uint32_t event, int wait)
 {
 	deprecated_atomic_or(&tasks[tskid].event, event);
@@ -217,11 +316,10 @@ uint32_t task_wait_event(int timeout_us)
 	int ret;
 	pthread_mutex_lock(&interrupt_lock);
 	if (timeout_us > 0)
-		tasks[tid].wake_time.val = get_time().val + timeout_us;
+		task_set_wake_time(tid, get_time().val + timeout_us);
 
 	/* Transfer control to scheduler */
-	pthread_cond_signal(&scheduler_cond);
-	pthread_cond_wait(&tasks[tid].resume, &run_lock);
+	task_switch_to_scheduler(tid);
 
 	/* Resume */
 	ret = deprecated_atomic_read_clear(&tasks[tid].event);
@@ -356,19 +454,11 @@ void wait_for_task_started_nosleep(void)
 
 static task_id_t task_get_next_wake(void)
 {
-	int i;
-	timestamp_t min_time;
-	int which_task = TASK_ID_INVALID;
-
-	min_time.val = ~0ull;
-
-	for (i = TASK_ID_COUNT - 1; i >= 0; --i)
-		if (min_time.val >= tasks[i].wake_time.val) {
-			min_time.val = tasks[i].wake_time.val;
-			which_task = i;
-		}
+	/* With no timeout pending, every task waits forever: pick idle */
+	if (!wake_queue_len)
+		return TASK_ID_IDLE;
 
-	return which_task;
+	return wake_queue[0];
 }
 
 static int fast_forward(void)
@@ -415,25 +505,28 @@ int task_start_called(void)
 
 void task_scheduler(void)
 {
-	int i;
+	int i, j;
 	timestamp_t now;
 
 	task_started = 1;
 
 	while (1) {
 		now = get_time();
-		i = TASK_ID_COUNT - 1;
-		while (i >= 0) {
-			/*
-			 * Only tasks with spawned threads are valid to be
-			 * resumed.
-			 */
-			if (tasks[i].thread) {
-				if (tasks[i].event ||
-				    now.val >= tasks[i].wake_time.val)
-					break;
-			}
-			--i;
+		/*
+		 * Only tasks with spawned threads are valid to be resumed.
+		 * Pick the highest priority one with an event pending...
+		 */
+		for (i = TASK_ID_COUNT - 1; i >= 0; --i)
+			if (tasks[i].thread && tasks[i].event)
+				break;
+		/* ...or whose timeout has expired. */
+		for (j = 0; j < wake_queue_len; j++) {
+			task_id_t w = wake_queue[j];
+
+			if (tasks[w].wake_time.val > now.val)
+				break;
+			if (w > i && tasks[w].thread)
+				i = w;
 		}
 		if (i < 0)
 			i = fast_forward();
@@ -441,23 +534,35 @@ void task_scheduler(void)
 		now = get_time();
 		if (now.val >= tasks[i].wake_time.val)
 			tasks[i].event |= TASK_EVENT_TIMER;
-		tasks[i].wake_time.val = ~0ull;
+		task_set_wake_time(i, ~0ull);
 		running_task_id = i;
 		tasks[i].started = 1;
-		pthread_cond_signal(&tasks[i].resume);
-		pthread_cond_wait(&scheduler_cond, &run_lock);
+		task_switch_from_scheduler(i);
 	}
 }
 
-void *_task_start_impl(void *a)
+test_mockable void interrupt_generator(void)
+{
+	has_interrupt_generator = 0;
+}
+
+void *_task_int_generator_start(void *d)
+{
+	my_task_id = TASK_ID_INT_GEN;
+	interrupt_generator();
+	return NULL;
+}
+
+#ifdef CONFIG_HOST_TASK_COROUTINES
+static void _task_start_impl(int tid)
 {
-	long tid = (long)a;
 	const struct task_args *arg = task_info + tid;
-	my_task_id = tid;
-	pthread_mutex_lock(&run_lock);
 
-	/* Wait for scheduler */
-	task_wait_event(1);
+	/*
+	 * The scheduler switched to us holding interrupt_lock, as if we were
+	 * returning from task_wait_event().
+	 */
+	pthread_mutex_unlock(&interrupt_lock);
 	tasks[tid].event = 0;
 
 	/* Start the task routine */
@@ -468,16 +573,83 @@ void *_task_start_impl(void *a)
 		task_wait_event(-1);
 }
 
-test_mockable void interrupt_generator(void)
+static void task_create(task_id_t tskid)
 {
-	has_interrupt_generator = 0;
+	ucontext_t *ctx = &tasks[tskid].context;
+
+	tasks[tskid].event = TASK_EVENT_WAKE;
+	tasks[tskid].wake_time.val = ~0ull;
+	tasks[tskid].started = 0;
+
+	getcontext(ctx);
+	ctx->uc_stack.ss_sp = malloc(COROUTINE_STACK_SIZE);
+	ctx->uc_stack.ss_size = COROUTINE_STACK_SIZE;
+	ctx->uc_link = NULL;
+	makecontext(ctx, (void (*)(void))_task_start_impl, 1, (int)tskid);
+
+	/* All tasks run on the scheduler thread, so interrupts go there. */
+	tasks[tskid].thread = pthread_self();
 }
 
-void *_task_int_generator_start(void *d)
+int task_start(void)
 {
-	my_task_id = TASK_ID_INT_GEN;
-	interrupt_generator();
-	return NULL;
+	pthread_mutex_init(&interrupt_lock, NULL);
+
+	/*
+	 * Initialize the hooks task first.  After its init, it will hand
+	 * control back to us to enable the remaining tasks.
+	 */
+	task_create(TASK_ID_HOOKS);
+
+	/* Hold interrupt_lock like a task switching out does. */
+	pthread_mutex_lock(&interrupt_lock);
+
+	pthread_create(&interrupt_thread, NULL,
+		       _task_int_generator_start, NULL);
+
+	task_switch_from_scheduler(TASK_ID_HOOKS);
+	task_enable_all_tasks_callback();
+
+	task_scheduler();
+
+	return 0;
+}
+
+static void task_enable_all_tasks_callback(void)
+{
+	int i;
+
+	/* Initialize the remaning tasks, they start when first scheduled. */
+	for (i = 0; i < TASK_ID_COUNT; ++i)
+		if (tasks[i].thread == (pthread_t)NULL)
+			task_create(i);
+}
+
+void task_enable_all_tasks(void)
+{
+	/*
+	 * Nothing to do: the hooks task is running on the scheduler thread,
+	 * which enables the other tasks once it waits for the next event.
+	 */
+}
+#else /* !CONFIG_HOST_TASK_COROUTINES */
+void *_task_start_impl(void *a)
+{
+	long tid = (long)a;
+	const struct task_args *arg = task_info + tid;
+	my_task_id = tid;
+	pthread_mutex_lock(&run_lock);
+
+	/* Wait for scheduler */
+	task_wait_event(1);
+	tasks[tid].event = 0;
+
+	/* Start the task routine */
+	(arg->routine)(arg->d);
+
+	/* Catch exited routine */
+	while (1)
+		task_wait_event(-1);
 }
 
 int task_start(void)
@@ -559,3 +731,4 @@ void task_enable_all_tasks(void)
 	/* Signal to the scheduler to enable the remaining tasks. */
 	pthread_cond_signal(&scheduler_cond);
 }
+#endif /* CONFIG_HOST_TASK_COROUTINES */
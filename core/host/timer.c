@@ -7,7 +7,9 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
+#include "host_test.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -50,6 +52,14 @@ test_mockable timestamp_t get_time(void)
 	return ret;
 }
 
+uint64_t host_get_wall_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * SECOND + ts.tv_nsec / 1000;
+}
+
 uint32_t __hw_clock_source_read(void)
 {
 	return get_time().le.lo;
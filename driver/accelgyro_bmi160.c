@@ -566,8 +566,10 @@ static int irq_handler(struct motion_sensor_t *s, uint32_t *event)
 #endif
 	} while (interrupt != 0);
 
-	if (IS_ENABLED(CONFIG_ACCEL_FIFO) && has_read_fifo)
+	if (IS_ENABLED(CONFIG_ACCEL_FIFO) && has_read_fifo) {
+		motion_sense_fifo_batch_stage();
 		motion_sense_fifo_commit_data();
+	}
 
 	return EC_SUCCESS;
 }
@@ -364,7 +364,7 @@ static void push_fifo_data(struct motion_sensor_t *accel, uint8_t *fifo,
 
 			vect.flags = 0;
 			vect.sensor_num = s - motion_sensors;
-			motion_sense_fifo_stage_data(&vect, s, 3, timestamp);
+			motion_sense_fifo_batch_add(&vect, timestamp);
 		}
 
 		fifo += OUT_XYZ_SIZE;
@@ -424,6 +424,7 @@ static int load_fifo(struct motion_sensor_t *s, const struct fstatus *fsts,
 		left -= length;
 	} while (left > 0);
 
+	motion_sense_fifo_batch_stage();
 	motion_sense_fifo_commit_data();
 
 	return EC_SUCCESS;
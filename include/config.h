@@ -53,6 +53,12 @@
 /* The amount of free entries that trigger an interrupt to the AP. */
 #undef CONFIG_ACCEL_FIFO_THRES
 
+/*
+ * Number of samples sensor drivers collect from their hardware FIFO before
+ * staging them into the sensor FIFO together.
+ */
+#define CONFIG_ACCEL_FIFO_BATCH_SIZE 8
+
 /*
  * Sensors in this mask are in forced mode: they needed to be polled
  * at their data rate frequency.
@@ -1369,6 +1375,7 @@
 #undef  CONFIG_CMD_RTC
 #undef  CONFIG_CMD_RTC_ALARM
 #define CONFIG_CMD_RW
+#undef  CONFIG_CMD_RWSIG
 #undef  CONFIG_CMD_SCRATCHPAD
 #undef	CONFIG_CMD_SEVEN_SEG_DISPLAY
 #define CONFIG_CMD_SHMEM
@@ -1512,6 +1519,18 @@
 /* Max length of a single line of input */
 #define CONFIG_CONSOLE_INPUT_LINE_SIZE 80
 
+/*
+ * Store cprints_tok() output as a format string ID plus the raw arguments in
+ * a binary ring, instead of formatting it onto the console.  The host reads
+ * the ring with the CONSOLE_READ_TOKENS subcommand of EC_CMD_CONSOLE_READ
+ * v1 (needs CONFIG_CONSOLE_ENABLE_READ_V1) and renders it from the format
+ * strings in ec.elf; see "ectool consoletokens".
+ */
+#undef CONFIG_CONSOLE_TOKENIZED_LOG
+
+/* Tokenized log ring size in bytes.  Must be a power of 2. */
+#define CONFIG_CONSOLE_TOKENIZED_LOG_SIZE 1024
+
 /* Enable verbose output to UART console and extra timestamp print precision. */
 #define CONFIG_CONSOLE_VERBOSE
 
@@ -2094,6 +2113,15 @@
 /* Config option to support 64-bit hostevents and wake-masks. */
 #define CONFIG_HOST_EVENT64
 
+/*
+ * Host emulator only: run all tasks as coroutines (ucontext) on the scheduler
+ * thread instead of one pthread per task. Task switches become a pair of
+ * swapcontext() calls rather than a condition variable handoff between
+ * threads. Not compatible with the sanitizer builds, which do not track
+ * stack switches.
+ */
+#undef CONFIG_HOST_TASK_COROUTINES
+
 /*
  * The host commands are sorted in the .rodata.hcmds section so use the binary
  * search algorithm to match a command to its handler
@@ -2106,6 +2134,15 @@
  */
 #undef CONFIG_HOSTCMD_ALIGNED
 
+/*
+ * Let commands declared with DECLARE_HOST_COMMAND_INPLACE() read their params
+ * directly from the transport buffer (e.g. the LPC/eSPI shared memory window),
+ * even when the interface provides a request_temp buffer to copy them to.
+ * The host must leave the buffer alone until the response is ready, as LPC
+ * hosts do while the EC reports busy.
+ */
+#undef CONFIG_HOSTCMD_INPLACE
+
 /*
  * Include host commands to fetch battery information from
  * ec_response_battery_static/dynamic_info structures, only makes sense when
@@ -2113,6 +2150,21 @@
  */
 #undef CONFIG_HOSTCMD_BATTERY_V2
 
+/*
+ * Record per-command call counts and latency (min/avg/max and a log2
+ * histogram) in host_command_process(), readable with EC_CMD_HOSTCMD_STATS
+ * and the hcstats console command.  CONFIG_HOSTCMD_STATS_COUNT is the number
+ * of distinct commands tracked; later commands are not recorded.
+ */
+#undef CONFIG_HOSTCMD_STATS
+#define CONFIG_HOSTCMD_STATS_COUNT 24
+
+/*
+ * Support EC_CMD_BATCH, which runs several host commands in one request to
+ * save the per-command protocol overhead of small reads.
+ */
+#undef CONFIG_HOSTCMD_BATCH
+
 /* Default hcdebug mode, e.g. HCDEBUG_OFF or HCDEBUG_NORMAL */
 #define CONFIG_HOSTCMD_DEBUG_MODE HCDEBUG_NORMAL
 
@@ -2215,6 +2267,13 @@
 /* Enable debugging and profiling statistics for hook functions */
 #undef CONFIG_HOOK_DEBUG
 
+/*
+ * Sort each hook table by priority once, from hook_pre_init() at boot, so
+ * every notification is a single linear walk instead of one scan of the
+ * table per distinct priority.  Costs one pointer of RAM per hook.
+ */
+#undef CONFIG_HOOK_SORTED_DISPATCH
+
 /*****************************************************************************/
 /* CRC configuration */
 
@@ -2224,6 +2283,12 @@
 /* Enable the software routine for CRC computation */
 #undef CONFIG_SW_CRC
 
+/*
+ * Hash bulk buffers 4 or 8 bytes at a time in the software CRC routine
+ * (slicing-by-4/8).  Each extra slice costs a 1 KB lookup table.
+ */
+#undef CONFIG_SW_CRC_SLICES
+
 /*****************************************************************************/
 
 /* Enable system hibernate */
@@ -2593,6 +2658,20 @@
 /*  Print keyboard scan time intervals. */
 #undef CONFIG_KEYBOARD_PRINT_SCAN_TIMES
 
+/*
+ * Adapt the keyboard scan period to key activity.  Scan every scan_period_us
+ * while keys are changing or debouncing, back off to at most
+ * CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US while they are held steady, and
+ * return to interrupt mode as soon as all keys are released and debounced.
+ * The keyboard interrupt is armed during the longer waits, so pressing a key
+ * on a row with nothing held still triggers a scan right away.  Releases, and
+ * presses on a row that already has a key down, don't raise the interrupt:
+ * while a key is held those are only seen at the next scan, up to
+ * CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US later.
+ */
+#undef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+#define CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US (12 * MSEC)
+
 /*
  * Support for extra runtime key combinations (e.g. alt+volup+h/r for hibernate
  * and warm reboot, respectively).
@@ -3284,6 +3363,13 @@
 /* Use RSA exponent 3 instead of F4 (65537) */
 #undef CONFIG_RSA_EXPONENT_3
 
+/*
+ * Do the RSA Montgomery arithmetic on 64-bit limbs. Only useful on 64-bit
+ * cores with a 64x64->128 multiply (e.g. the host emulator). The work
+ * buffer passed to rsa_verify() must then be 8-byte aligned.
+ */
+#undef CONFIG_RSA_64BIT_LIMBS
+
 /*
  * Adjust the compiler optimization flags for the RSA code to get a speed-up
  * at the expense of a small code size delta.
@@ -3363,9 +3449,19 @@
 /* Support computing of other hash sizes (without the VBOOT code) */
 #undef CONFIG_SHA256
 
-/* Unroll some loops in SHA256_transform for better performance. */
+/*
+ * Use the fully unrolled SHA256_transform, with big-endian word loads and a
+ * 16-word rolling message schedule. Faster, but larger code.
+ */
 #undef CONFIG_SHA256_UNROLLED
 
+/*
+ * On x86_64 builds (host emulator), use the SHA extensions for
+ * SHA256_transform when the CPU supports them, falling back to the C
+ * implementation otherwise.
+ */
+#undef CONFIG_SHA256_X86_SHA_EXT
+
 /* Emulate the CLZ (Count Leading Zeros) in software for CPU lacking support */
 #undef CONFIG_SOFTWARE_CLZ
 
@@ -3921,6 +4017,15 @@
 #define CONFIG_USB_PRL_SM
 #define CONFIG_USB_PE_SM
 
+/*
+ * Let the TCPMv2 PD task sleep until the next state machine deadline or task
+ * event, instead of waking every 5 ms, while the port is idle. Conditions
+ * that are polled rather than signalled by an event are still checked at
+ * least every CONFIG_USB_PD_TICKLESS_MAX_SLEEP microseconds.
+ */
+#undef CONFIG_USB_PD_TICKLESS
+#define CONFIG_USB_PD_TICKLESS_MAX_SLEEP (1000 * MSEC)
+
 /* Enables PD Console commands */
 #define CONFIG_USB_PD_CONSOLE_CMD
 
@@ -4697,6 +4802,20 @@
 /* Support computing hash of code for verified boot */
 #undef CONFIG_VBOOT_HASH
 
+/*
+ * Bytes the vboot hash module reads from flash and feeds to SHA256 per step.
+ * When storage is not memory mapped, the read buffer comes from shared memory
+ * so this must not exceed CONFIG_SHAREDMEM_MINIMUM_SIZE.
+ */
+#define CONFIG_VBOOT_HASH_CHUNK_SIZE 1024
+
+/*
+ * Number of chunks hashed back to back per deferred call, reusing the same
+ * read buffer, before yielding the hook task. Raising this shortens the total
+ * hash time at the cost of longer hook task latency.
+ */
+#define CONFIG_VBOOT_HASH_CHUNKS_PER_CALL 1
+
 /* Support for secure temporary storage for verified boot */
 #undef CONFIG_VSTORE
 
@@ -5011,6 +5130,12 @@
 #endif
 #endif
 
+/* Only the DRP Type-C state machine reports deadlines for the tickless task */
+#if defined(CONFIG_USB_PD_TICKLESS) && defined(CONFIG_USB_TYPEC_SM) && \
+	!defined(CONFIG_USB_DRP_ACC_TRYSRC)
+#error "CONFIG_USB_PD_TICKLESS requires CONFIG_USB_DRP_ACC_TRYSRC."
+#endif
+
 /******************************************************************************/
 /*
  * Automatically define CONFIG_HOSTCMD_X86 if either child option is defined.
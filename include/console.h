@@ -135,6 +135,36 @@ int cprintf(enum console_channel channel, const char *format, ...);
 __attribute__((__format__(__printf__, 2, 3)))
 int cprints(enum console_channel channel, const char *format, ...);
 
+/**
+ * Add a record to the tokenized log, without formatting it.  Use
+ * cprints_tok() instead of calling this directly, so the format string is
+ * placed where the host can find it.
+ *
+ * @param channel	Output channel
+ * @param format	Format string in the log_fmts section
+ *
+ * @return non-zero if arguments were dropped.
+ */
+int cprints_tokenized(enum console_channel channel, const char *format, ...);
+
+/*
+ * Like cprints(), but with CONFIG_CONSOLE_TOKENIZED_LOG the output goes to the
+ * tokenized log as a format string ID plus the raw arguments instead.  The
+ * format must be a string literal.
+ */
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+#define cprints_tok(channel, format, args...) ({			\
+	static const char __log_fmt[]					\
+		__attribute__((section(".rodata.log_fmts"))) = format;	\
+	if (0)								\
+		cprints(channel, format, ## args);			\
+	cprints_tokenized(channel, __log_fmt, ## args);			\
+})
+#else
+#define cprints_tok(channel, format, args...) \
+	cprints(channel, format, ## args)
+#endif
+
 /**
  * Flush the console output for all channels.
  */
@@ -160,8 +190,10 @@ void console_has_input(void);
  *
  * @param name          Command name; must not be the beginning of another
  *                      existing command name.  Must be less than 15 characters
- *                      long (excluding null terminator).  Note this is NOT in
- *                      quotes so it can be concatenated to form a struct name.
+ *                      long (excluding null terminator) and lowercase, since
+ *                      lookup relies on the linker sorting the command section
+ *                      by name.  Note this is NOT in quotes so it can be
+ *                      concatenated to form a struct name.
  * @param routine       Command handling routine, of the form
  *                      int handler(int argc, char **argv)
  * @param argdesc       String describing arguments to command; NULL if none.
@@ -22,6 +22,14 @@ void crc32_hash32(uint32_t val);
 
 void crc32_hash16(uint16_t val);
 
+/**
+ * Add a buffer to the CRC.
+ *
+ * With CONFIG_SW_CRC_SLICES, the aligned part of the buffer is hashed a slice
+ * of 4 or 8 bytes at a time, which is much faster for bulk data.
+ */
+void crc32_hash(const void *buf, int size);
+
 uint32_t crc32_result(void);
 
 /* Provided context variant */
@@ -34,6 +42,8 @@ void crc32_ctx_hash16(uint32_t *ctx, uint16_t val);
 
 void crc32_ctx_hash8(uint32_t *ctx, uint8_t val);
 
+void crc32_ctx_hash(uint32_t *ctx, const void *buf, int size);
+
 uint32_t crc32_ctx_result(uint32_t *ctx);
 
 #endif /* CONFIG_HW_CRC */
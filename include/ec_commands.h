@@ -4200,13 +4200,37 @@ struct ec_params_charge_control {
 
 enum ec_console_read_subcmd {
 	CONSOLE_READ_NEXT = 0,
-	CONSOLE_READ_RECENT
+	CONSOLE_READ_RECENT,
+	CONSOLE_READ_TOKENS,
 };
 
 struct ec_params_console_read_v1 {
 	uint8_t subcmd; /* enum ec_console_read_subcmd */
 } __ec_align1;
 
+/*
+ * CONSOLE_READ_TOKENS returns whole records from the tokenized log snapshot,
+ * oldest first, instead of a string.  Empty response if there are no more
+ * records.
+ *
+ * Each record is this header followed by the arguments of the format
+ * string, packed in order with no padding:
+ *   - '*' width or precision, %c and 32-bit integers: 4 bytes
+ *   - 64-bit integers: 8 bytes
+ *   - %s: the string, null-terminated
+ *   - %pP: 4 bytes
+ *   - %pT: 8 bytes, microseconds
+ *   - %ph: 1 byte length, then the bytes
+ *   - %pb: 4 bytes value, then 1 byte digit count
+ * Arguments which do not fit in the record are dropped.
+ */
+struct ec_console_token_record {
+	uint8_t size;		/* Size of the record, including this header */
+	uint8_t channel;	/* Console channel */
+	uint16_t fmt;		/* Format string offset from __log_fmts */
+	uint32_t time_ms;	/* Timestamp in milliseconds */
+} __ec_align1;
+
 /*****************************************************************************/
 
 /*
@@ -5777,6 +5801,12 @@ struct ec_response_rwsig_check_status {
 	uint32_t status;
 } __ec_align4;
 
+/* Version 1 also reports how long the verification took */
+struct ec_response_rwsig_check_status_v1 {
+	uint32_t status;
+	uint32_t verify_time_us;
+} __ec_align4;
+
 /* For controlling RWSIG task */
 #define EC_CMD_RWSIG_ACTION	0x011D
 
@@ -6523,6 +6553,87 @@ struct ec_response_typec_status {
 	/* TODO(b/167700356): Add revisions and source cap PDOs */
 } __ec_align1;
 
+/*****************************************************************************/
+/*
+ * Get host command latency statistics, one command per call.
+ *
+ * Requires CONFIG_HOSTCMD_STATS.  Entries are numbered in the order the EC
+ * first saw each command; read entries 0 to num_entries - 1.  An index past
+ * the end returns only num_entries (command and count are 0).
+ */
+#define EC_CMD_HOSTCMD_STATS 0x0134
+
+/* Clear all statistics, after returning the requested entry */
+#define EC_HOSTCMD_STATS_RESET BIT(0)
+
+/*
+ * Number of latency histogram buckets.  Bucket 0 counts commands which took
+ * less than 2 us, bucket n counts [2^n, 2^(n+1)) us, and the last bucket
+ * counts everything longer.
+ */
+#define EC_HOSTCMD_STATS_BUCKETS 20
+
+struct ec_params_hostcmd_stats {
+	uint8_t index;		/* Entry to read */
+	uint8_t flags;		/* EC_HOSTCMD_STATS_* */
+} __ec_align1;
+
+struct ec_response_hostcmd_stats {
+	uint8_t num_entries;	/* Number of entries in use */
+	uint8_t reserved;
+	uint16_t command;	/* Host command of this entry */
+	uint32_t count;		/* Number of calls */
+	uint32_t min_us;	/* Shortest call */
+	uint32_t max_us;	/* Longest call */
+	uint32_t avg_us;	/* Average call */
+	/* Calls per latency bucket, saturating at 0xffff */
+	uint16_t histogram[EC_HOSTCMD_STATS_BUCKETS];
+} __ec_align4;
+
+/*****************************************************************************/
+/*
+ * Run several host commands with one request.
+ *
+ * Requires CONFIG_HOSTCMD_BATCH.  The params are a struct ec_params_batch,
+ * followed by num_cmds sub-commands, each a struct ec_batch_request followed
+ * by its params.  The response is a struct ec_response_batch, followed by a
+ * struct ec_batch_response and the response data of each sub-command the EC
+ * ran.  Sub-command params and response data are padded with
+ * EC_BATCH_ALIGN().
+ *
+ * The EC runs the sub-commands in order, and stops before the first one whose
+ * response_max would not fit in the response; num_cmds in the response is
+ * the number it ran.  A failing sub-command does not stop the batch.
+ * Batches cannot be nested, and EC_CMD_REBOOT_EC and EC_CMD_FLASH_ERASE,
+ * which may respond before they are done, fail with EC_RES_INVALID_PARAM.
+ */
+#define EC_CMD_BATCH 0x0135
+
+#define EC_BATCH_ALIGN(size) (((size) + 3) & ~3)
+
+struct ec_params_batch {
+	uint8_t num_cmds;	/* Number of sub-commands */
+	uint8_t reserved[3];
+} __ec_align4;
+
+struct ec_batch_request {
+	uint16_t command;	/* Host command */
+	uint8_t version;	/* Host command version */
+	uint8_t reserved;
+	uint16_t params_size;	/* Size of the params which follow */
+	uint16_t response_max;	/* Maximum size of the response data */
+} __ec_align4;
+
+struct ec_response_batch {
+	uint8_t num_cmds;	/* Number of sub-commands run */
+	uint8_t reserved[3];
+} __ec_align4;
+
+struct ec_batch_response {
+	uint16_t result;	/* EC_RES_* of the sub-command */
+	uint16_t response_size;	/* Size of the response data which follows */
+} __ec_align4;
+
 /*****************************************************************************/
 /* The command range 0x200-0x2FF is reserved for Rotor. */
 
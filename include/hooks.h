@@ -258,6 +258,14 @@ struct hook_data {
  */
 void hook_notify(enum hook_type type);
 
+/**
+ * Prepare the hook tables for dispatch.
+ *
+ * Must be called from main() before interrupts are enabled, since interrupt
+ * handlers may call hook_notify() for some hook types.
+ */
+void hook_pre_init(void);
+
 struct deferred_data {
 	/* Deferred function pointer */
 	void (*routine)(void);
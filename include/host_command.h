@@ -123,11 +123,19 @@ struct host_command {
 	 */
 	enum ec_status (*handler)(struct host_cmd_handler_args *args);
 	/* Command code */
-	int command;
+	uint16_t command;
+	/* HOST_CMD_FLAG_* */
+	uint16_t flags;
 	/* Mask of supported versions */
 	int version_mask;
 };
 
+/*
+ * The handler reads all of its params before it writes any response data,
+ * so the params can stay in a request buffer shared with the response.
+ */
+#define HOST_CMD_FLAG_INPLACE BIT(0)
+
 #ifdef CONFIG_HOST_EVENT64
 typedef uint64_t host_event_t;
 #define HOST_EVENT_CPRINTS(str, e)	CPRINTS("%s 0x%016" PRIx64, str, e)
@@ -261,7 +269,7 @@ void host_packet_receive(struct host_packet *pkt);
 	const struct host_command __keep __no_sanitize_address		\
 	EXPAND(0x0000, command)						\
 	__attribute__((section(".rodata.hcmds."EXPANDSTR(0x0000, command)))) \
-		= {routine, command, version_mask}
+		= {routine, command, 0, version_mask}
 
 /*
  * Register a private host command handler with
@@ -272,8 +280,18 @@ void host_packet_receive(struct host_packet *pkt);
 	EXPAND(EC_CMD_BOARD_SPECIFIC_BASE, command) \
 	__attribute__((section(".rodata.hcmds."\
 	EXPANDSTR(EC_CMD_BOARD_SPECIFIC_BASE, command)))) \
-		= {routine, EC_PRIVATE_HOST_COMMAND_VALUE(command), \
+		= {routine, EC_PRIVATE_HOST_COMMAND_VALUE(command), 0, \
 		   version_mask}
+
+/*
+ * Register a host command handler whose params may be read in place from the
+ * transport buffer (see HOST_CMD_FLAG_INPLACE)
+ */
+#define DECLARE_HOST_COMMAND_INPLACE(command, routine, version_mask)	\
+	const struct host_command __keep __no_sanitize_address		\
+	EXPAND(0x0000, command)						\
+	__attribute__((section(".rodata.hcmds."EXPANDSTR(0x0000, command)))) \
+		= {routine, command, HOST_CMD_FLAG_INPLACE, version_mask}
 #else
 #define DECLARE_HOST_COMMAND(command, routine, version_mask)    \
 	enum ec_status (routine)(struct host_cmd_handler_args *args)       \
@@ -281,6 +299,9 @@ void host_packet_receive(struct host_packet *pkt);
 
 #define DECLARE_PRIVATE_HOST_COMMAND(command, routine, version_mask)	\
 	DECLARE_HOST_COMMAND(command, routine, version_mask)
+
+#define DECLARE_HOST_COMMAND_INPLACE(command, routine, version_mask)	\
+	DECLARE_HOST_COMMAND(command, routine, version_mask)
 #endif
 
 /**
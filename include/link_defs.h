@@ -82,6 +82,12 @@ extern const struct deferred_data __deferred_funcs[];
 extern const struct deferred_data __deferred_funcs_end[];
 extern uint64_t __deferred_until[];
 extern uint64_t __deferred_until_end[];
+extern uint32_t __deferred_queue[];
+extern uint32_t __deferred_queue_end[];
+
+/* Priority-sorted hook table (CONFIG_HOOK_SORTED_DISPATCH) */
+extern const struct hook_data *__hooks_sorted[];
+extern const struct hook_data *__hooks_sorted_end[];
 
 /* I2C fake devices for unit testing */
 extern const struct test_i2c_xfer __test_i2c_xfer[];
@@ -91,6 +97,10 @@ extern const struct test_i2c_xfer __test_i2c_xfer_end[];
 extern const struct host_command __hcmds[];
 extern const struct host_command __hcmds_end[];
 
+/* Tokenized log format strings (CONFIG_CONSOLE_TOKENIZED_LOG) */
+extern const char __log_fmts[];
+extern const char __log_fmts_end[];
+
 /* MKBP events */
 extern const struct mkbp_event_source __mkbp_evt_srcs[];
 extern const struct mkbp_event_source __mkbp_evt_srcs_end[];
@@ -66,6 +66,44 @@ void motion_sense_fifo_stage_data(
 	int valid_data,
 	uint32_t time);
 
+/**
+ * Stage a batch of sensor samples to the fifo, all taken at the same time.
+ * This is equivalent to calling motion_sense_fifo_stage_data() on each of them
+ * with valid_data set to 3, but only locks the fifo once.
+ *
+ * @param data samples to insert in the FIFO, sensor_num tells which sensor
+ *             each sample comes from
+ * @param count number of samples
+ * @param time accurate time (ideally measured in an interrupt) the samples
+ *             were taken at
+ */
+void motion_sense_fifo_stage_batch(
+	struct ec_response_motion_sensor_data *data,
+	int count,
+	uint32_t time);
+
+/**
+ * Add a sensor sample to the batch shared by the sensor drivers. The batch is
+ * staged when it is full or when a sample with a different time is added.
+ * Call motion_sense_fifo_batch_stage() before committing the data.
+ *
+ * Only call this from the motion sense task.
+ *
+ * @param data sample to add, sensor_num tells which sensor it comes from
+ * @param time accurate time (ideally measured in an interrupt) the sample
+ *             was taken at
+ */
+void motion_sense_fifo_batch_add(
+	const struct ec_response_motion_sensor_data *data,
+	uint32_t time);
+
+/**
+ * Stage the samples in the batch shared by the sensor drivers.
+ *
+ * Only call this from the motion sense task.
+ */
+void motion_sense_fifo_batch_stage(void);
+
 /**
  * Commit all the currently staged data to the fifo. Doing so makes it readable
  * to the AP.
@@ -76,6 +76,29 @@
 __stdlib_compat int vfnprintf(int (*addchar)(void *context, int c),
 			      void *context, const char *format, va_list args);
 
+/**
+ * Print formatted output to a function, passing runs of characters in bulk.
+ *
+ * Like vfnprintf(), but literal runs of the format string and converted
+ * fields are passed to addspan() in a single call.  Padding and %ph output
+ * still go through addchar().
+ *
+ * @param addchar	Function to be called for single characters, as for
+ *			vfnprintf().
+ * @param addspan	Function to be called for runs of characters.  Will be
+ *			passed the same context, a pointer to the characters
+ *			and their count.  Should return 0 if all characters
+ *			were accepted or non-zero if any were dropped due to
+ *			overflow.  If NULL, addchar() is used for everything.
+ * @param context	Context pointer to pass to addchar() and addspan()
+ * @param format	Format string (see above for acceptable formats)
+ * @param args		Parameters
+ * @return EC_SUCCESS, or EC_ERROR_OVERFLOW if the output was truncated.
+ */
+int vfnprintf_span(int (*addchar)(void *context, int c),
+		   int (*addspan)(void *context, const char *s, int len),
+		   void *context, const char *format, va_list args);
+
 /**
  * Print formatted outut to a string.
  *
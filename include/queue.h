@@ -184,6 +184,23 @@ struct queue_chunk queue_get_write_chunk(struct queue const *q, size_t offset);
  */
 struct queue_chunk queue_get_read_chunk(struct queue const *q);
 
+/*
+ * Scatter/gather versions of the above: return all of the free space (or all
+ * of the units) as up to two chunks, the second one only used when it wraps
+ * around the end of the queue buffer.  Unused chunks have a count of 0.
+ * Return the total number of units in the chunks.  Write or read the chunks
+ * in order, then call queue_advance_tail or queue_advance_head with the
+ * number of units written or read, with the same rules as above.
+ *
+ * These let a producer or consumer move everything it can with at most two
+ * copies (or directly in the queue buffer), instead of a unit at a time.
+ */
+size_t queue_get_write_chunks(struct queue const *q,
+			      struct queue_chunk chunks[2]);
+
+size_t queue_get_read_chunks(struct queue const *q,
+			     struct queue_chunk chunks[2]);
+
 /*
  * Move the queue head pointer forward count units.  This discards count
  * elements from the head of the queue.  It will only discard up to the total
@@ -242,6 +259,36 @@ size_t queue_peek_memcpy(struct queue const *q,
 				const void *src,
 				size_t n));
 
+/*
+ * Single-producer/single-consumer access.
+ *
+ * When units are only ever added from one context and removed from one other
+ * context (for example an interrupt handler feeding a task), these can be
+ * used in place of the add and remove functions above without masking
+ * interrupts or taking a mutex around them.  Each side only writes its own
+ * index; it reads the other side's index with acquire ordering, and publishes
+ * its own with release ordering once the units are copied.
+ *
+ * The queue policy is called from both contexts, so it must be safe to call
+ * from each of them.  Don't mix these with the functions above on the same
+ * side of a queue without other locking, and only queue_init() the queue
+ * when neither side can be using it.
+ */
+
+/* Add one unit to queue, from its only producer. */
+size_t queue_spsc_add_unit(struct queue const *q, const void *src);
+
+/* Add multiple units to queue, from its only producer. */
+size_t queue_spsc_add_units(struct queue const *q, const void *src,
+			    size_t count);
+
+/* Remove one unit from the begin of the queue, from its only consumer. */
+size_t queue_spsc_remove_unit(struct queue const *q, void *dest);
+
+/* Remove multiple units from the begin of the queue, from its only consumer. */
+size_t queue_spsc_remove_units(struct queue const *q, void *dest,
+			       size_t count);
+
 /*
  * These macros will statically select the queue functions based on the number
  * of units that are to be added or removed if they can.  The single unit add
@@ -10,6 +10,13 @@
 #include "rsa.h"
 
 #ifndef __ASSEMBLER__
+
+/*
+ * Returns how long the last RW signature check took, in microseconds
+ * (0 if it has not run).
+ */
+uint32_t rwsig_get_verify_time(void);
+
 #ifdef HAS_TASK_RWSIG
 /* The functions below only make sense if RWSIG task is defined. */
 
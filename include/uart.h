@@ -349,6 +349,9 @@ enum ec_status uart_console_read_buffer_init(void);
  * previous snapshot (so if current snapshot and previous snapshot has overlaps,
  * only new content will be returned).
  *
+ * If `type` is CONSOLE_READ_TOKENS, this will return whole records from the
+ * tokenized log snapshot instead of a string.
+ *
  * @param type		an ec_console_read_subcmd value.
  * @param dest		output buffer, it will be a null-terminated string.
  * @param dest_size	size of output buffer.
@@ -361,6 +364,17 @@ int uart_console_read_buffer(uint8_t type,
 			     uint16_t dest_size,
 			     uint16_t *write_count);
 
+/**
+ * Add a record to the tokenized log (CONFIG_CONSOLE_TOKENIZED_LOG).
+ *
+ * @param channel	Console channel
+ * @param format	Format string; must be in the log_fmts section, see
+ *			cprints_tok()
+ * @param args		Parameters
+ * @return EC_SUCCESS, or EC_ERROR_OVERFLOW if arguments were dropped.
+ */
+int uart_log_tokens(int channel, const char *format, va_list args);
+
 /**
  * Initialize tx buffer head and tail
  */
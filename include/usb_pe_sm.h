@@ -28,6 +28,15 @@ enum pe_error {
  */
 void pe_run(int port, int evt, int en);
 
+/**
+ * Returns when the Policy Engine State Machine next needs to run
+ *
+ * @param port USB-C port number
+ * @return absolute time of the next deadline, SM_DEADLINE_POLL or
+ *         SM_DEADLINE_NONE
+ */
+uint64_t pe_get_next_deadline(int port);
+
 /**
  * Sets the debug level for the PRL layer
  *
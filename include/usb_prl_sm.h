@@ -60,6 +60,15 @@ void prl_reset_soft(int port);
  */
 void prl_run(int port, int evt, int en);
 
+/**
+ * Returns when the Protocol Layer State Machine next needs to run
+ *
+ * @param port USB-C port number
+ * @return absolute time of the next deadline, SM_DEADLINE_POLL or
+ *         SM_DEADLINE_NONE
+ */
+uint64_t prl_get_next_deadline(int port);
+
 /**
  * Set the PD revision
  *
@@ -50,6 +50,18 @@ enum sm_local_state {
 	SM_PAUSED,
 };
 
+/*
+ * Deadlines reported by the *_get_next_deadline() functions, see
+ * CONFIG_USB_PD_TICKLESS. A deadline is otherwise an absolute time in
+ * microseconds, as returned by get_time().
+ *
+ * SM_DEADLINE_POLL - the state machine must keep being run at the normal
+ *                    polling rate
+ * SM_DEADLINE_NONE - the state machine only needs to run on a task event
+ */
+#define SM_DEADLINE_POLL 0
+#define SM_DEADLINE_NONE 0xffffffffffffffff
+
 /*
  * A state machine can use these debug levels to regulate the amount of debug
  * information printed on the EC console
@@ -289,6 +289,15 @@ void tc_event_check(int port, int evt);
  */
 void tc_run(const int port);
 
+/**
+ * Returns when the TypeC layer statemachine next needs to run
+ *
+ * @param port USB-C port number
+ * @return absolute time of the next deadline, SM_DEADLINE_POLL or
+ *         SM_DEADLINE_NONE
+ */
+uint64_t tc_get_next_deadline(int port);
+
 /**
  * Sets the debug level for the TC layer
  *
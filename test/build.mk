@@ -26,7 +26,10 @@ test-list-host += charge_manager_drp_charging
 test-list-host += charge_ramp
 test-list-host += compile_time_macros
 test-list-host += console_edit
+test-list-host += console_lookup
+test-list-host += console_tokens
 test-list-host += crc32
+test-list-host += crc32_slices4
 test-list-host += entropy
 test-list-host += extpwr_gpio
 test-list-host += fan
@@ -38,6 +41,7 @@ test-list-host += fpsensor_crypto
 test-list-host += fpsensor_state
 test-list-host += gyro_cal
 test-list-host += hooks
+test-list-host += hooks_sorted
 test-list-host += host_command
 test-list-host += i2c_bitbang
 test-list-host += inductive_charging
@@ -47,7 +51,8 @@ test-list-host += is_enabled_error
 test-list-host += kasa
 test-list-host += kb_8042
 test-list-host += kb_mkbp
-#test-list-host += kb_scan	# crbug.com/976974
+test-list-host += kb_scan
+test-list-host += kb_scan_adaptive
 test-list-host += lid_sw
 test-list-host += lightbar
 test-list-host += mag_cal
@@ -60,21 +65,26 @@ test-list-host += mutex
 test-list-host += newton_fit
 test-list-host += online_calibration
 test-list-host += pingpong
+test-list-host += pingpong_coro
 test-list-host += power_button
 test-list-host += printf
 test-list-host += queue
 test-list-host += rsa
 test-list-host += rsa3
+test-list-host += rsa_64bit
 test-list-host += rtc
 test-list-host += sbs_charging_v2
 test-list-host += sha256
 test-list-host += sha256_unrolled
+test-list-host += sha256_sha_ext
 test-list-host += shmalloc
 test-list-host += static_if
 test-list-host += static_if_error
 test-list-host += system
 test-list-host += thermal
 test-list-host += timer_dos
+test-list-host += timer_dos_coro
+test-list-host += uart_buffering
 test-list-host += uptime
 test-list-host += usb_common
 test-list-host += usb_pd_int
@@ -89,17 +99,22 @@ test-list-host += usb_sm_framework_h0
 test-list-host += usb_typec_vpd
 test-list-host += usb_typec_ctvpd
 test-list-host += usb_typec_drp_acc_trysrc
+test-list-host += usb_typec_drp_acc_trysrc_tickless
 test-list-host += usb_prl_old
 test-list-host += usb_tcpmv2_tcpci
 test-list-host += usb_prl
+test-list-host += usb_prl_tickless
 test-list-host += usb_prl_noextended
 test-list-host += usb_pe_drp_old
 test-list-host += usb_pe_drp_old_noextended
 test-list-host += usb_pe_drp
+test-list-host += usb_pe_drp_tickless
 test-list-host += usb_pe_drp_noextended
 test-list-host += utils
 test-list-host += utils_str
 test-list-host += vboot
+test-list-host += vboot_hash
+test-list-host += vboot_hash_shmem
 test-list-host += x25519
 test-list-host += stillness_detector
 endif
@@ -134,7 +149,10 @@ charge_manager_drp_charging-y=charge_manager.o
 charge_ramp-y+=charge_ramp.o
 compile_time_macros-y=compile_time_macros.o
 console_edit-y=console_edit.o
+console_lookup-y=console_lookup.o
+console_tokens-y=console_tokens.o
 crc32-y=crc32.o
+crc32_slices4-y=crc32.o
 entropy-y=entropy.o
 extpwr_gpio-y=extpwr_gpio.o
 fan-y=fan.o
@@ -146,6 +164,7 @@ fpsensor_crypto-y=fpsensor_crypto.o
 fpsensor_state-y=fpsensor_state.o
 gyro_cal-y=gyro_cal.o
 hooks-y=hooks.o
+hooks_sorted-y=hooks.o
 host_command-y=host_command.o
 i2c_bitbang-y=i2c_bitbang.o
 inductive_charging-y=inductive_charging.o
@@ -154,6 +173,7 @@ is_enabled-y=is_enabled.o
 kb_8042-y=kb_8042.o
 kb_mkbp-y=kb_mkbp.o
 kb_scan-y=kb_scan.o
+kb_scan_adaptive-y=kb_scan.o
 lid_sw-y=lid_sw.o
 lightbar-y=lightbar.o
 mag_cal-y=mag_cal.o
@@ -168,6 +188,7 @@ mpu-y=mpu.o
 mutex-y=mutex.o
 newton_fit-y=newton_fit.o
 pingpong-y=pingpong.o
+pingpong_coro-y=pingpong.o
 power_button-y=power_button.o
 powerdemo-y=powerdemo.o
 printf-y=printf.o
@@ -176,12 +197,14 @@ rollback-y=rollback.o
 rollback_entropy-y=rollback_entropy.o
 rsa-y=rsa.o
 rsa3-y=rsa.o
+rsa_64bit-y=rsa.o
 rtc-y=rtc.o
 scratchpad-y=scratchpad.o
 sbs_charging-y=sbs_charging.o
 sbs_charging_v2-y=sbs_charging_v2.o
 sha256-y=sha256.o
 sha256_unrolled-y=sha256.o
+sha256_sha_ext-y=sha256.o
 shmalloc-y=shmalloc.o
 static_if-y=static_if.o
 stm32f_rtc-y=stm32f_rtc.o
@@ -190,6 +213,8 @@ system-y=system.o
 thermal-y=thermal.o
 timer_calib-y=timer_calib.o
 timer_dos-y=timer_dos.o
+timer_dos_coro-y=timer_dos.o
+uart_buffering-y=uart_buffering.o
 uptime-y=uptime.o
 usb_common-y=usb_common_test.o fake_battery.o
 usb_pd_int-y=usb_pd_int.o
@@ -205,17 +230,23 @@ usb_typec_vpd-y=usb_typec_ctvpd.o vpd_api.o usb_sm_checks.o fake_usbc.o
 usb_typec_ctvpd-y=usb_typec_ctvpd.o vpd_api.o usb_sm_checks.o fake_usbc.o
 usb_typec_drp_acc_trysrc-y=usb_typec_drp_acc_trysrc.o vpd_api.o \
 	usb_sm_checks.o
+usb_typec_drp_acc_trysrc_tickless-y=usb_typec_drp_acc_trysrc.o vpd_api.o \
+	usb_sm_checks.o
 usb_prl_old-y=usb_prl_old.o usb_sm_checks.o fake_usbc.o
 usb_prl-y=usb_prl.o usb_sm_checks.o
+usb_prl_tickless-y=usb_prl.o usb_sm_checks.o
 usb_prl_noextended-y=usb_prl_noextended.o usb_sm_checks.o fake_usbc.o
 usb_pe_drp_old-y=usb_pe_drp_old.o usb_sm_checks.o fake_usbc.o
 usb_pe_drp_old_noextended-y=usb_pe_drp_old.o usb_sm_checks.o fake_usbc.o
 usb_pe_drp-y=usb_pe_drp.o usb_sm_checks.o
+usb_pe_drp_tickless-y=usb_pe_drp.o usb_sm_checks.o
 usb_pe_drp_noextended-y=usb_pe_drp_noextended.o usb_sm_checks.o
 usb_tcpmv2_tcpci-y=usb_tcpmv2_tcpci.o vpd_api.o usb_sm_checks.o
 utils-y=utils.o
 utils_str-y=utils_str.o
 vboot-y=vboot.o
+vboot_hash-y=vboot_hash.o
+vboot_hash_shmem-y=vboot_hash.o
 float-y=fp.o
 fp-y=fp.o
 x25519-y=x25519.o
@@ -0,0 +1,133 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test console command lookup.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "host_test.h"
+#include "link_defs.h"
+#include "test_util.h"
+#include "util.h"
+
+const struct console_command *find_command(const char *name);
+
+static int command_dummy(int argc, char **argv)
+{
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(lkpalpha, command_dummy, NULL, NULL);
+DECLARE_CONSOLE_COMMAND(lkpalphabet, command_dummy, NULL, NULL);
+DECLARE_CONSOLE_COMMAND(lkpbeta, command_dummy, NULL, NULL);
+
+/* Reference linear lookup, with the same unique-prefix semantics */
+static const struct console_command *find_command_linear(const char *name)
+{
+	const struct console_command *cmd, *match = NULL;
+	int match_length = strlen(name);
+
+	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
+		if (!strncasecmp(name, cmd->name, match_length)) {
+			if (match)
+				return NULL;
+			if (cmd->name[match_length] == '\0')
+				return cmd;
+			match = cmd;
+		}
+	}
+
+	return match;
+}
+
+static const char *lookup_name(const char *name)
+{
+	const struct console_command *cmd = find_command(name);
+
+	return cmd ? cmd->name : "(none)";
+}
+
+static int test_sorted(void)
+{
+	const struct console_command *cmd;
+
+	for (cmd = __cmds + 1; cmd < __cmds_end; cmd++)
+		TEST_LT(strcasecmp(cmd[-1].name, cmd->name), 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_lookup(void)
+{
+	TEST_ASSERT(!strcasecmp(lookup_name("lkpalpha"), "lkpalpha"));
+	TEST_ASSERT(!strcasecmp(lookup_name("lkpalphabet"), "lkpalphabet"));
+	TEST_ASSERT(!strcasecmp(lookup_name("lkpalphab"), "lkpalphabet"));
+	TEST_ASSERT(!strcasecmp(lookup_name("lkpb"), "lkpbeta"));
+	TEST_ASSERT(!strcasecmp(lookup_name("LKPBeta"), "lkpbeta"));
+
+	/* Ambiguous prefixes */
+	TEST_ASSERT(find_command("lkp") == NULL);
+	TEST_ASSERT(find_command("lkpalph") == NULL);
+
+	/* No match, before, between and after all commands */
+	TEST_ASSERT(find_command("0") == NULL);
+	TEST_ASSERT(find_command("lkpc") == NULL);
+	TEST_ASSERT(find_command("zzzzzz") == NULL);
+
+	return EC_SUCCESS;
+}
+
+static int test_matches_linear(void)
+{
+	const struct console_command *cmd;
+	char name[16];
+	int len;
+
+	/* Every command and every prefix of it resolves as before */
+	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
+		for (len = 1; len <= strlen(cmd->name); len++) {
+			strzcpy(name, cmd->name, len + 1);
+			TEST_ASSERT(find_command(name) ==
+				    find_command_linear(name));
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+static void test_lookup_speed(void)
+{
+	const int rounds = 1000;
+	const int ncmds = __cmds_end - __cmds;
+	uint64_t t0, t1, t2;
+	int i, j;
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < rounds; i++)
+		for (j = 0; j < ncmds; j++)
+			find_command_linear(__cmds[j].name);
+	t1 = host_get_wall_time_us();
+	for (i = 0; i < rounds; i++)
+		for (j = 0; j < ncmds; j++)
+			find_command(__cmds[j].name);
+	t2 = host_get_wall_time_us();
+
+	ccprintf("%d commands, per lookup: linear %d ns, binary %d ns\n",
+		 ncmds, (int)((t1 - t0) * 1000 / (rounds * ncmds)),
+		 (int)((t2 - t1) * 1000 / (rounds * ncmds)));
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_sorted);
+	RUN_TEST(test_lookup);
+	RUN_TEST(test_matches_linear);
+
+	/* do not check result, just as a benchmark */
+	test_lookup_speed();
+
+	test_print_result();
+}
@@ -0,0 +1,262 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests the tokenized console log.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_test.h"
+#include "link_defs.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+static uint8_t log[CONFIG_CONSOLE_TOKENIZED_LOG_SIZE];
+
+/* Tokenized log ring, from common/uart_buffering.c */
+extern uint8_t tok_buf[CONFIG_CONSOLE_TOKENIZED_LOG_SIZE];
+extern uint32_t tok_head;
+extern uint32_t tok_tail;
+extern uint32_t tok_checksum;
+
+#define TOK_BUF_MASK (CONFIG_CONSOLE_TOKENIZED_LOG_SIZE - 1)
+
+/*
+ * Snapshot and read the whole log, and return the newest record.  A snapshot
+ * covers everything still in the log, like CONSOLE_READ_NEXT.
+ */
+static const uint8_t *read_last_record(int *size)
+{
+	struct ec_console_token_record r;
+	uint16_t count = 0;
+	int pos;
+
+	uart_console_read_buffer_init();
+	uart_console_read_buffer(CONSOLE_READ_TOKENS, (char *)log, sizeof(log),
+				 &count);
+
+	for (pos = 0; pos < count; pos += r.size) {
+		memcpy(&r, log + pos, sizeof(r));
+		if (pos + r.size == count)
+			break;
+	}
+
+	*size = r.size;
+	return log + pos;
+}
+
+static int test_record(void)
+{
+	static const uint8_t bytes[] = { 0x12, 0xab };
+	uint64_t ts = 0x123456789aULL;
+	struct ec_console_token_record r;
+	const uint8_t *rec, *p;
+	int32_t v32;
+	uint64_t v64;
+	int size;
+
+	TEST_EQ(cprints_tok(CC_COMMAND, "a%d b%s c%lld d%ph e%pT f%*x g%c",
+			    -5, "str", 1LL << 40, HEX_BUF(bytes, 2), &ts, 4,
+			    0xbeef, 'z'), EC_SUCCESS, "%d");
+	rec = read_last_record(&size);
+
+	memcpy(&r, rec, sizeof(r));
+	TEST_EQ((int)r.size, size, "%d");
+	TEST_EQ((int)r.channel, CC_COMMAND, "%d");
+	TEST_ASSERT(r.fmt < __log_fmts_end - __log_fmts);
+	TEST_ASSERT(!strcasecmp(__log_fmts + r.fmt,
+				"a%d b%s c%lld d%ph e%pT f%*x g%c"));
+	TEST_LE(r.time_ms, (uint32_t)(get_time().val / 1000), "%u");
+
+	p = rec + sizeof(r);
+	memcpy(&v32, p, 4);
+	TEST_EQ(v32, -5, "%d");
+	TEST_ASSERT_ARRAY_EQ(p + 4, "str", 4);
+	memcpy(&v64, p + 8, 8);
+	TEST_ASSERT(v64 == 1ULL << 40);
+	TEST_EQ((int)p[16], 2, "%d");
+	TEST_ASSERT_ARRAY_EQ(p + 17, bytes, 2);
+	memcpy(&v64, p + 19, 8);
+	TEST_ASSERT(v64 == ts);
+	memcpy(&v32, p + 27, 4);
+	TEST_EQ(v32, 4, "%d");
+	memcpy(&v32, p + 31, 4);
+	TEST_EQ(v32, 0xbeef, "%d");
+	memcpy(&v32, p + 35, 4);
+	TEST_EQ(v32, 'z', "%d");
+	TEST_EQ(size, (int)sizeof(r) + 39, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_truncated(void)
+{
+	static char long_str[200];
+	struct ec_console_token_record r;
+	const uint8_t *rec;
+	int size;
+
+	memset(long_str, 'x', sizeof(long_str) - 1);
+
+	TEST_EQ(cprints_tok(CC_COMMAND, "%s %d", long_str, 1),
+		EC_ERROR_OVERFLOW, "%d");
+	rec = read_last_record(&size);
+
+	/* The string is cut short but still terminated; the int is dropped */
+	memcpy(&r, rec, sizeof(r));
+	TEST_LT(size, (int)sizeof(long_str), "%d");
+	TEST_EQ((int)rec[size - 1], 0, "%d");
+	TEST_EQ((int)strlen((const char *)rec + sizeof(r)),
+		size - (int)sizeof(r) - 1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_drop_oldest(void)
+{
+	const int n = CONFIG_CONSOLE_TOKENIZED_LOG_SIZE / 8;
+	struct ec_console_token_record r;
+	int i, size, pos, first = -1, count = 0;
+	uint32_t v;
+
+	for (i = 0; i < n; i++)
+		cprints_tok(CC_COMMAND, "seq %d", i);
+
+	/* Read back in small pieces; responses only hold whole records */
+	uart_console_read_buffer_init();
+	do {
+		uint16_t got = 0;
+
+		uart_console_read_buffer(CONSOLE_READ_TOKENS, (char *)log, 30,
+					 &got);
+		size = got;
+		for (pos = 0; pos < size; pos += r.size) {
+			memcpy(&r, log + pos, sizeof(r));
+			TEST_EQ((int)r.size, (int)sizeof(r) + 4, "%d");
+			TEST_ASSERT(!strcasecmp(__log_fmts + r.fmt, "seq %d"));
+			memcpy(&v, log + pos + sizeof(r), 4);
+			if (first < 0)
+				first = v;
+			TEST_EQ((int)v, first + count, "%d");
+			count++;
+		}
+		TEST_EQ(pos, size, "%d");
+	} while (size);
+
+	/* The oldest records were dropped to fit the newest ones */
+	TEST_GT(first, 0, "%d");
+	TEST_EQ(first + count, n, "%d");
+	TEST_EQ(count, CONFIG_CONSOLE_TOKENIZED_LOG_SIZE / 12, "%d");
+
+	return EC_SUCCESS;
+}
+
+/* Read every record in a new snapshot, and check that they are whole */
+static int read_all_records(int *records)
+{
+	struct ec_console_token_record r;
+	uint16_t count = 0;
+	int pos;
+
+	uart_console_read_buffer_init();
+	uart_console_read_buffer(CONSOLE_READ_TOKENS, (char *)log, sizeof(log),
+				 &count);
+
+	*records = 0;
+	for (pos = 0; pos < count; pos += r.size) {
+		memcpy(&r, log + pos, sizeof(r));
+		TEST_ASSERT(r.size >= sizeof(r));
+		(*records)++;
+	}
+	TEST_EQ(pos, (int)count, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_corrupt_log(void)
+{
+	int i, records;
+
+	/* A preserved log with a zero record size is thrown away at init */
+	for (i = 0; i < 4; i++)
+		cprints_tok(CC_COMMAND, "seq %d", i);
+	tok_buf[tok_tail & TOK_BUF_MASK] = 0;
+	tok_checksum = tok_head ^ tok_tail;
+	uart_init_buffer();
+	TEST_EQ(tok_head - tok_tail, 0, "%d");
+
+	/* So is one whose records don't end on tok_head */
+	for (i = 0; i < 4; i++)
+		cprints_tok(CC_COMMAND, "seq %d", i);
+	tok_head--;
+	tok_checksum = tok_head ^ tok_tail;
+	uart_init_buffer();
+	TEST_EQ(tok_head - tok_tail, 0, "%d");
+
+	/* An intact log is kept */
+	for (i = 0; i < 4; i++)
+		cprints_tok(CC_COMMAND, "seq %d", i);
+	tok_checksum = tok_head ^ tok_tail;
+	uart_init_buffer();
+	TEST_EQ(read_all_records(&records), EC_SUCCESS, "%d");
+	TEST_EQ(records, 4, "%d");
+
+	/* Reading stops at a bad record instead of looping on it */
+	tok_buf[(tok_tail + sizeof(struct ec_console_token_record) + 4) &
+		TOK_BUF_MASK] = 0;
+	TEST_EQ(read_all_records(&records), EC_SUCCESS, "%d");
+	TEST_EQ(records, 1, "%d");
+
+	/* Making room past a bad record drops the whole log */
+	for (i = 0; i < CONFIG_CONSOLE_TOKENIZED_LOG_SIZE / 8; i++)
+		cprints_tok(CC_COMMAND, "seq %d", i);
+	TEST_EQ(read_all_records(&records), EC_SUCCESS, "%d");
+	TEST_GT(records, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static void test_log_speed(void)
+{
+	const int n = 256;
+	uint64_t w0, text_us, token_us;
+	int i;
+
+	w0 = host_get_wall_time_us();
+	for (i = 0; i < n; i++)
+		cprints_tok(CC_COMMAND, "hook call deferred 0x%pP", test_reset);
+	token_us = host_get_wall_time_us() - w0;
+
+	/* Only time appending to the UART buffer, not draining it */
+	uart_flush_output();
+	interrupt_disable();
+	w0 = host_get_wall_time_us();
+	for (i = 0; i < n; i++)
+		cprints(CC_COMMAND, "hook call deferred 0x%pP", test_reset);
+	text_us = host_get_wall_time_us() - w0;
+	interrupt_enable();
+	uart_flush_output();
+
+	ccprintf("%d lines: cprints %lld us, cprints_tok %lld us\n", n,
+		 (long long)text_us, (long long)token_us);
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_record);
+	RUN_TEST(test_truncated);
+	RUN_TEST(test_drop_oldest);
+	RUN_TEST(test_corrupt_log);
+
+	/* do not check result, just as a benchmark */
+	test_log_speed();
+
+	test_print_result();
+}
@@ -8,6 +8,7 @@
 #include "common.h"
 #include "console.h"
 #include "crc.h"
+#include "host_test.h"
 #include "test_util.h"
 #include "util.h"
 
@@ -63,6 +64,68 @@ static int test_kat0(void)
 	return EC_SUCCESS;
 }
 
+static uint8_t buffer[256 * 1024];
+
+// test that bulk hashing matches bytes at a time, for any alignment
+static int test_bulk(void)
+{
+	uint32_t crc, crc_bulk;
+	int offset, size, i;
+
+	for (i = 0; i < 256; ++i)
+		buffer[i] = prng_no_seed();
+
+	for (offset = 0; offset < 8; ++offset) {
+		for (size = 0; size < 64; ++size) {
+			crc32_ctx_init(&crc);
+			for (i = 0; i < size; ++i)
+				crc32_ctx_hash8(&crc, buffer[offset + i]);
+
+			crc32_ctx_init(&crc_bulk);
+			crc32_ctx_hash(&crc_bulk, buffer + offset, size);
+
+			TEST_ASSERT(crc32_ctx_result(&crc) ==
+				    crc32_ctx_result(&crc_bulk));
+		}
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_bulk_kat0(void)
+{
+	const char input[] = "The quick brown fox jumps over the lazy dog";
+
+	crc32_init();
+	crc32_hash(input, strlen(input));
+	TEST_ASSERT(crc32_result() == 0x414fa339);
+
+	return EC_SUCCESS;
+}
+
+static void test_speed(void)
+{
+	uint32_t crc;
+	uint64_t t0, t1, t2;
+	int size, i;
+
+	for (size = 4 * 1024; size <= sizeof(buffer); size *= 4) {
+		t0 = host_get_wall_time_us();
+		crc32_ctx_init(&crc);
+		for (i = 0; i < size; ++i)
+			crc32_ctx_hash8(&crc, buffer[i]);
+		t1 = host_get_wall_time_us();
+		crc32_ctx_init(&crc);
+		crc32_ctx_hash(&crc, buffer, size);
+		t2 = host_get_wall_time_us();
+
+		ccprintf("CRC32 %6d bytes: bytewise %lld us, "
+			 "bulk (%d slices) %lld us\n",
+			 size, (long long)(t1 - t0), CONFIG_SW_CRC_SLICES,
+			 (long long)(t2 - t1));
+	}
+}
+
 void run_test(int argc, char **argv)
 {
 	test_reset();
@@ -70,6 +133,11 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_static_version);
 	RUN_TEST(test_8);
 	RUN_TEST(test_kat0);
+	RUN_TEST(test_bulk);
+	RUN_TEST(test_bulk_kat0);
+
+	/* do not check result, just as a benchmark */
+	test_speed();
 
 	test_print_result();
 }
@@ -11,6 +11,10 @@
 #include "gpio.h"
 #include "hooks.h"
 #include "host_command.h"
+#ifdef EMU_BUILD
+#include "host_test.h"
+#include "persistence.h"
+#endif
 #include "system.h"
 #include "task.h"
 #include "test_util.h"
@@ -334,6 +338,53 @@ static int test_overwrite_other(void)
 	return EC_SUCCESS;
 }
 
+#ifdef EMU_BUILD
+#define FLASH_SPEED_ITERATIONS 256
+
+static void test_flash_speed(void)
+{
+	char data[CONFIG_FLASH_WRITE_IDEAL_SIZE];
+	uint32_t offset = system_is_in_rw() ? CONFIG_RO_STORAGE_OFF :
+					      CONFIG_RW_STORAGE_OFF;
+	uint64_t t0, t1;
+	FILE *f;
+	int i;
+
+	memset(data, 0xa5, sizeof(data));
+	mock_is_running_img = 0;
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < FLASH_SPEED_ITERATIONS; i++)
+		flash_physical_write(offset + (i * sizeof(data)) % 0x1000,
+				     sizeof(data), data);
+	t1 = host_get_wall_time_us();
+	ccprintf("Flash write %d x %d bytes: %lld us\n",
+		 FLASH_SPEED_ITERATIONS, (int)sizeof(data),
+		 (long long)(t1 - t0));
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < FLASH_SPEED_ITERATIONS; i++)
+		flash_physical_erase(offset + (i * sizeof(data)) % 0x1000,
+				     sizeof(data));
+	t1 = host_get_wall_time_us();
+	ccprintf("Flash erase %d x %d bytes: %lld us\n",
+		 FLASH_SPEED_ITERATIONS, (int)sizeof(data),
+		 (long long)(t1 - t0));
+
+	/* Cost of rewriting the whole image on every operation, for reference */
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < FLASH_SPEED_ITERATIONS; i++) {
+		f = get_persistent_storage("flash_speed", "wb");
+		fwrite(__host_flash, CONFIG_FLASH_SIZE, 1, f);
+		release_persistent_storage(f);
+	}
+	t1 = host_get_wall_time_us();
+	remove_persistent_storage("flash_speed");
+	ccprintf("Full image flush x %d: %lld us\n",
+		 FLASH_SPEED_ITERATIONS, (long long)(t1 - t0));
+}
+#endif
+
 static int test_op_failure(void)
 {
 	mock_flash_op_fail = EC_ERROR_UNKNOWN;
@@ -454,6 +505,10 @@ static void run_test_step1(void)
 	RUN_TEST(test_overwrite_current);
 	RUN_TEST(test_overwrite_other);
 	RUN_TEST(test_op_failure);
+#ifdef EMU_BUILD
+	/* do not check result, just as a benchmark */
+	test_flash_speed();
+#endif
 	RUN_TEST(test_flash_info);
 	RUN_TEST(test_region_info);
 	RUN_TEST(test_write_protect);
@@ -8,6 +8,8 @@
 #include "common.h"
 #include "console.h"
 #include "hooks.h"
+#include "host_test.h"
+#include "link_defs.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
@@ -51,6 +53,28 @@ static void second_hook(void)
 }
 DECLARE_HOOK(HOOK_SECOND, second_hook, HOOK_PRIO_DEFAULT);
 
+/*
+ * Hooks declared out of priority order, with ties, to check that dispatch
+ * calls them by priority.  Each one records its rank in priority order.
+ */
+static int soc_hook_rank[5];
+static int soc_hook_count;
+
+#define DECLARE_SOC_HOOK(name, rank, prio)				\
+	static void soc_hook_##name(void)				\
+	{								\
+		if (soc_hook_count < ARRAY_SIZE(soc_hook_rank))		\
+			soc_hook_rank[soc_hook_count] = rank;		\
+		soc_hook_count++;					\
+	}								\
+	DECLARE_HOOK(HOOK_BATTERY_SOC_CHANGE, soc_hook_##name, prio)
+
+DECLARE_SOC_HOOK(last, 2, HOOK_PRIO_LAST);
+DECLARE_SOC_HOOK(default, 1, HOOK_PRIO_DEFAULT);
+DECLARE_SOC_HOOK(first, 0, HOOK_PRIO_FIRST);
+DECLARE_SOC_HOOK(default2, 1, HOOK_PRIO_DEFAULT);
+DECLARE_SOC_HOOK(last2, 2, HOOK_PRIO_LAST);
+
 static void deferred_func(void)
 {
 	deferred_call_count++;
@@ -105,6 +129,61 @@ static int test_priority(void)
 	return EC_SUCCESS;
 }
 
+static int test_priority_order(void)
+{
+	int i;
+
+	soc_hook_count = 0;
+	hook_notify(HOOK_BATTERY_SOC_CHANGE);
+	TEST_EQ(soc_hook_count, (int)ARRAY_SIZE(soc_hook_rank), "%d");
+
+	for (i = 1; i < ARRAY_SIZE(soc_hook_rank); i++)
+		TEST_ASSERT(soc_hook_rank[i - 1] <= soc_hook_rank[i]);
+
+	return EC_SUCCESS;
+}
+
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+/* Per hook type slices of __hooks_sorted, from common/hooks.c */
+extern const struct hook_data **sorted_hooks[];
+
+static int test_sorted_tables(void)
+{
+	const struct hook_data **p;
+	int type;
+
+	/* Every hook is in exactly one slice, and the slices fit */
+	TEST_ASSERT(sorted_hooks[0] == __hooks_sorted);
+	TEST_ASSERT(sorted_hooks[HOOK_USB_PD_CONNECT + 1] - __hooks_sorted ==
+		    __hooks_usb_pd_connect_end - __hooks_init);
+	TEST_ASSERT(sorted_hooks[HOOK_USB_PD_CONNECT + 1] <=
+		    __hooks_sorted_end);
+
+	/* Each slice is in priority order */
+	for (type = 0; type <= HOOK_USB_PD_CONNECT; type++) {
+		TEST_ASSERT(sorted_hooks[type] <= sorted_hooks[type + 1]);
+		for (p = sorted_hooks[type] + 1; p < sorted_hooks[type + 1];
+		     p++)
+			TEST_ASSERT(p[-1]->priority <= p[0]->priority);
+	}
+
+	return EC_SUCCESS;
+}
+#endif
+
+static void test_notify_speed(void)
+{
+	uint64_t t0, t1;
+	int i;
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < 100000; i++)
+		hook_notify(HOOK_BATTERY_SOC_CHANGE);
+	t1 = host_get_wall_time_us();
+	ccprintf("hook_notify x 100000 duration %lld us\n",
+		 (long long)(t1 - t0));
+}
+
 static int test_deferred(void)
 {
 	deferred_call_count = 0;
@@ -134,6 +213,44 @@ static int test_deferred(void)
 	return EC_SUCCESS;
 }
 
+/* Deferred routines record the order they are called in */
+static int deferred_order[3];
+static int deferred_order_count;
+
+#define DECLARE_ORDER_DEFERRED(id)					\
+	static void order_deferred_##id(void)				\
+	{								\
+		if (deferred_order_count < ARRAY_SIZE(deferred_order))	\
+			deferred_order[deferred_order_count] = id;	\
+		deferred_order_count++;					\
+	}								\
+	DECLARE_DEFERRED(order_deferred_##id)
+
+DECLARE_ORDER_DEFERRED(0);
+DECLARE_ORDER_DEFERRED(1);
+DECLARE_ORDER_DEFERRED(2);
+
+static int test_deferred_order(void)
+{
+	deferred_order_count = 0;
+	hook_call_deferred(&order_deferred_2_data, 30 * MSEC);
+	hook_call_deferred(&order_deferred_0_data, 10 * MSEC);
+	hook_call_deferred(&order_deferred_1_data, 50 * MSEC);
+
+	/* Reschedule and cancel already queued routines */
+	hook_call_deferred(&order_deferred_1_data, 20 * MSEC);
+	hook_call_deferred(&deferred_func_data, 15 * MSEC);
+	hook_call_deferred(&deferred_func_data, -1);
+
+	usleep(100 * MSEC);
+	TEST_EQ(deferred_order_count, 3, "%d");
+	TEST_EQ(deferred_order[0], 0, "%d");
+	TEST_EQ(deferred_order[1], 1, "%d");
+	TEST_EQ(deferred_order[2], 2, "%d");
+
+	return EC_SUCCESS;
+}
+
 static int repeating_deferred_count;
 static void deferred_repeating_func(void);
 DECLARE_DEFERRED(deferred_repeating_func);
@@ -166,7 +283,16 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_init_hook);
 	RUN_TEST(test_ticks);
 	RUN_TEST(test_priority);
+	RUN_TEST(test_priority_order);
+#ifdef CONFIG_HOOK_SORTED_DISPATCH
+	RUN_TEST(test_sorted_tables);
+#endif
+
+	/* do not check result, just as a benchmark */
+	test_notify_speed();
+
 	RUN_TEST(test_deferred);
+	RUN_TEST(test_deferred_order);
 	RUN_TEST(test_repeating_deferred);
 
 	test_print_result();
@@ -8,6 +8,7 @@
 #include "common.h"
 #include "console.h"
 #include "host_command.h"
+#include "host_test.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -27,6 +28,10 @@ struct ec_response_hello *r =
 struct ec_response_get_chip_info *chip_info_r =
 	(struct ec_response_get_chip_info *)(resp_buf + sizeof(*resp));
 
+/* LPC-style shared memory window: the response overwrites the request */
+static uint8_t window[EC_LPC_HOST_PACKET_SIZE] __aligned(4);
+static uint8_t window_temp[EC_LPC_HOST_PACKET_SIZE] __aligned(4);
+
 static void hostcmd_respond(struct host_packet *pkt)
 {
 	task_wake(TASK_ID_TEST_RUNNER);
@@ -300,6 +305,355 @@ static int test_hostcmd_clears_unused_data(void)
 	return EC_SUCCESS;
 }
 
+static void hostcmd_fill_window(uint16_t command, const void *params,
+				int size)
+{
+	struct ec_host_request *h = (struct ec_host_request *)window;
+
+	h->struct_version = 3;
+	h->checksum = 0;
+	h->command = command;
+	h->command_version = 0;
+	h->reserved = 0;
+	h->data_len = size;
+	memcpy(h + 1, params, size);
+	h->checksum = calculate_checksum((const char *)window,
+					 sizeof(*h) + size);
+
+	pkt.send_response = hostcmd_respond;
+	pkt.request = window;
+	pkt.request_temp = window_temp;
+	pkt.request_max = sizeof(window);
+	/* Like LPC, which does not know the request size */
+	pkt.request_size = sizeof(window);
+	pkt.response = window;
+	pkt.response_max = sizeof(window);
+	pkt.driver_result = 0;
+}
+
+static int test_hostcmd_in_place(void)
+{
+	struct ec_host_response *h = (struct ec_host_response *)window;
+	uint8_t *data = window + sizeof(*h);
+	struct ec_params_read_memmap p = {
+		.offset = EC_MEMMAP_ID,
+		.size = 4,
+	};
+	int i;
+
+	/* Junk everywhere, to see what gets copied and cleared */
+	memset(window, 0xAA, sizeof(window));
+	memset(window_temp, 0xAA, sizeof(window_temp));
+	hostcmd_fill_window(EC_CMD_READ_MEMMAP, &p, sizeof(p));
+	host_packet_receive(&pkt);
+	task_wait_event(-1);
+
+	TEST_ASSERT(calculate_checksum((const char *)window,
+				       sizeof(*h) + h->data_len) == 0);
+	TEST_ASSERT(h->result == EC_RES_SUCCESS);
+	TEST_ASSERT(h->data_len == 4);
+	TEST_ASSERT(data[0] == 'E' && data[1] == 'C');
+
+	/* Params were read from the window, not copied past the header */
+	TEST_ASSERT(window_temp[sizeof(struct ec_host_request)] == 0xAA);
+
+	/* The rest of the response buffer was still cleared */
+	for (i = sizeof(*h) + h->data_len; i < sizeof(window); i++)
+		TEST_ASSERT(window[i] == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_hostcmd_not_in_place(void)
+{
+	struct ec_host_response *h = (struct ec_host_response *)window;
+	uint8_t *data = window + sizeof(*h);
+	struct ec_params_test_protocol p = {
+		.ec_result = EC_RES_SUCCESS,
+		.ret_len = sizeof(p.buf),
+	};
+
+	/* TEST_PROTOCOL is not declared in place, its params are copied */
+	memset(p.buf, 0x55, sizeof(p.buf));
+	memset(window_temp, 0xAA, sizeof(window_temp));
+	hostcmd_fill_window(EC_CMD_TEST_PROTOCOL, &p, sizeof(p));
+	host_packet_receive(&pkt);
+	task_wait_event(-1);
+
+	TEST_ASSERT(h->result == EC_RES_SUCCESS);
+	TEST_ASSERT(calculate_checksum((const char *)window,
+				       sizeof(*h) + h->data_len) == 0);
+
+	/* The params were copied out before the response overwrote them */
+	TEST_ASSERT_ARRAY_EQ(window_temp + sizeof(struct ec_host_request),
+			     (uint8_t *)&p, sizeof(p));
+	TEST_ASSERT(h->data_len == sizeof(p.buf));
+	TEST_ASSERT_ARRAY_EQ(data, p.buf, sizeof(p.buf));
+
+	return EC_SUCCESS;
+}
+
+static int hostcmd_read_stats(int index, int flags,
+			      struct ec_response_hostcmd_stats *r)
+{
+	struct ec_params_hostcmd_stats p = { .index = index, .flags = flags };
+
+	return test_send_host_command(EC_CMD_HOSTCMD_STATS, 0, &p, sizeof(p),
+				      r, sizeof(*r));
+}
+
+static int test_hostcmd_stats(void)
+{
+	struct ec_params_hello hello = { .in_data = 0 };
+	struct ec_response_hello hello_r;
+	struct ec_params_get_cmd_versions ver = { .cmd = EC_CMD_HELLO };
+	struct ec_response_get_cmd_versions ver_r;
+	struct ec_response_hostcmd_stats r;
+	int i, sum;
+
+	/* Start from a clean slate */
+	TEST_ASSERT(hostcmd_read_stats(0, EC_HOSTCMD_STATS_RESET, &r) ==
+		    EC_RES_SUCCESS);
+
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(test_send_host_command(EC_CMD_HELLO, 0,
+						   &hello, sizeof(hello),
+						   &hello_r, sizeof(hello_r)) ==
+			    EC_RES_SUCCESS);
+	TEST_ASSERT(test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 0,
+					   &ver, sizeof(ver),
+					   &ver_r, sizeof(ver_r)) ==
+		    EC_RES_SUCCESS);
+	/* Unknown commands don't take up a slot */
+	TEST_ASSERT(test_send_host_command(0x7fff, 0, NULL, 0, NULL, 0) ==
+		    EC_RES_INVALID_COMMAND);
+
+	/* Entries are in order of first use; the stats command isn't one */
+	TEST_ASSERT(hostcmd_read_stats(0, 0, &r) == EC_RES_SUCCESS);
+	TEST_ASSERT(r.num_entries == 2);
+	TEST_ASSERT(r.command == EC_CMD_HELLO);
+	TEST_ASSERT(r.count == 3);
+	TEST_ASSERT(r.min_us <= r.avg_us && r.avg_us <= r.max_us);
+	for (i = 0, sum = 0; i < EC_HOSTCMD_STATS_BUCKETS; i++)
+		sum += r.histogram[i];
+	TEST_ASSERT(sum == 3);
+
+	TEST_ASSERT(hostcmd_read_stats(1, 0, &r) == EC_RES_SUCCESS);
+	TEST_ASSERT(r.command == EC_CMD_GET_CMD_VERSIONS);
+	TEST_ASSERT(r.count == 1);
+	TEST_ASSERT(r.min_us == r.max_us && r.avg_us == r.max_us);
+
+	/* Past the end: only the number of entries */
+	TEST_ASSERT(hostcmd_read_stats(2, EC_HOSTCMD_STATS_RESET, &r) ==
+		    EC_RES_SUCCESS);
+	TEST_ASSERT(r.num_entries == 2);
+	TEST_ASSERT(r.command == 0 && r.count == 0);
+
+	TEST_ASSERT(hostcmd_read_stats(0, 0, &r) == EC_RES_SUCCESS);
+	TEST_ASSERT(r.num_entries == 0);
+
+	return EC_SUCCESS;
+}
+
+/* Test command: reports it is in progress, then returns its param */
+#define EC_CMD_TEST_IN_PROGRESS 0x3ffe
+
+static enum ec_status
+hostcmd_test_in_progress(struct host_cmd_handler_args *args)
+{
+	const uint32_t *p = args->params;
+	enum ec_status result = *p;
+
+	args->result = EC_RES_IN_PROGRESS;
+	host_send_response(args);
+
+	return result;
+}
+DECLARE_HOST_COMMAND(EC_CMD_TEST_IN_PROGRESS, hostcmd_test_in_progress,
+		     EC_VER_MASK(0));
+
+static int hostcmd_comms_processing(void)
+{
+	struct ec_response_get_comms_status status;
+
+	if (test_send_host_command(EC_CMD_GET_COMMS_STATUS, 0, NULL, 0,
+				   &status, sizeof(status)) != EC_RES_SUCCESS)
+		return -1;
+
+	return !!(status.flags & EC_COMMS_STATUS_PROCESSING);
+}
+
+static int test_hostcmd_resend_response(void)
+{
+	int i;
+
+	hostcmd_fill_in_default();
+	req->command = EC_CMD_TEST_IN_PROGRESS;
+	p->in_data = EC_RES_OVERFLOW;
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_IN_PROGRESS);
+	TEST_ASSERT(resp->data_len == 0);
+
+	for (i = 0; i < 100 && hostcmd_comms_processing(); i++)
+		msleep(1);
+	TEST_ASSERT(hostcmd_comms_processing() == 0);
+
+	/* The result can be read once */
+	TEST_ASSERT(test_send_host_command(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					   NULL, 0) == EC_RES_OVERFLOW);
+	TEST_ASSERT(test_send_host_command(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					   NULL, 0) == EC_RES_UNAVAILABLE);
+
+	return EC_SUCCESS;
+}
+
+/* Append a sub-command to a batch; returns the new end of the params */
+static uint8_t *hostcmd_batch_add(uint8_t *out, uint16_t command,
+				  const void *params, int params_size,
+				  int response_max)
+{
+	struct ec_batch_request *req = (struct ec_batch_request *)out;
+
+	memset(req, 0, sizeof(*req) + EC_BATCH_ALIGN(params_size));
+	req->command = command;
+	req->params_size = params_size;
+	req->response_max = response_max;
+	memcpy(req + 1, params, params_size);
+
+	return out + sizeof(*req) + EC_BATCH_ALIGN(params_size);
+}
+
+static int test_hostcmd_batch(void)
+{
+	uint32_t params[32];
+	uint32_t response[32];
+	struct ec_params_batch *bp = (struct ec_params_batch *)params;
+	struct ec_response_batch *br = (struct ec_response_batch *)response;
+	struct ec_params_hello hello = { .in_data = 0x11223344 };
+	struct ec_params_get_cmd_versions ver = { .cmd = EC_CMD_HELLO };
+	struct ec_params_reboot_ec reboot = { .cmd = EC_REBOOT_COLD };
+	const struct ec_batch_response *res;
+	uint8_t *out = (uint8_t *)(bp + 1);
+	const uint8_t *in = (const uint8_t *)(br + 1);
+	int rv;
+
+	memset(bp, 0, sizeof(*bp));
+	bp->num_cmds = 5;
+	out = hostcmd_batch_add(out, EC_CMD_HELLO, &hello, sizeof(hello),
+				sizeof(struct ec_response_hello));
+	out = hostcmd_batch_add(out, 0x3fff, NULL, 0, 0);
+	out = hostcmd_batch_add(out, EC_CMD_BATCH, bp, sizeof(*bp), 0);
+	out = hostcmd_batch_add(out, EC_CMD_REBOOT_EC, &reboot,
+				sizeof(reboot), 0);
+	out = hostcmd_batch_add(out, EC_CMD_GET_CMD_VERSIONS,
+				&ver, sizeof(ver),
+				sizeof(struct ec_response_get_cmd_versions));
+
+	rv = test_send_host_command(EC_CMD_BATCH, 0, params,
+				    out - (uint8_t *)params,
+				    response, sizeof(response));
+	TEST_ASSERT(rv == EC_RES_SUCCESS);
+	TEST_ASSERT(br->num_cmds == 5);
+
+	res = (const struct ec_batch_response *)in;
+	TEST_ASSERT(res->result == EC_RES_SUCCESS);
+	TEST_ASSERT(res->response_size == sizeof(struct ec_response_hello));
+	TEST_ASSERT(((const struct ec_response_hello *)(res + 1))->out_data ==
+		    0x12243648);
+	in += sizeof(*res) + EC_BATCH_ALIGN(res->response_size);
+
+	/* Failures don't stop the batch, and have no data */
+	res = (const struct ec_batch_response *)in;
+	TEST_ASSERT(res->result == EC_RES_INVALID_COMMAND);
+	TEST_ASSERT(res->response_size == 0);
+	in += sizeof(*res);
+
+	/* Nested batches and commands which respond early are refused */
+	res = (const struct ec_batch_response *)in;
+	TEST_ASSERT(res->result == EC_RES_INVALID_PARAM);
+	in += sizeof(*res);
+
+	res = (const struct ec_batch_response *)in;
+	TEST_ASSERT(res->result == EC_RES_INVALID_PARAM);
+	in += sizeof(*res);
+
+	res = (const struct ec_batch_response *)in;
+	TEST_ASSERT(res->result == EC_RES_SUCCESS);
+	TEST_ASSERT(((const struct ec_response_get_cmd_versions *)(res + 1))
+		    ->version_mask == EC_VER_MASK(0));
+
+	/* Stops before a response which might not fit */
+	memset(bp, 0, sizeof(*bp));
+	bp->num_cmds = 2;
+	out = (uint8_t *)(bp + 1);
+	out = hostcmd_batch_add(out, EC_CMD_HELLO, &hello, sizeof(hello),
+				sizeof(struct ec_response_hello));
+	out = hostcmd_batch_add(out, EC_CMD_HELLO, &hello, sizeof(hello),
+				sizeof(response));
+	rv = test_send_host_command(EC_CMD_BATCH, 0, params,
+				    out - (uint8_t *)params,
+				    response, sizeof(response));
+	TEST_ASSERT(rv == EC_RES_SUCCESS);
+	TEST_ASSERT(br->num_cmds == 1);
+
+	/* Truncated params */
+	rv = test_send_host_command(EC_CMD_BATCH, 0, params,
+				    out - (uint8_t *)params - 1,
+				    response, sizeof(response));
+	TEST_ASSERT(rv == EC_RES_INVALID_PARAM);
+
+	return EC_SUCCESS;
+}
+
+static void test_hostcmd_speed(void)
+{
+	const int rounds = 10000;
+	struct ec_params_hello hello = { .in_data = 0x11223344 };
+	struct ec_params_read_memmap memmap = { .offset = 0, .size = 0xe0 };
+	uint8_t batch[64] __aligned(4);
+	uint8_t *out;
+	uint64_t t0;
+	int i;
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < rounds; i++) {
+		hostcmd_fill_window(EC_CMD_HELLO, &hello, sizeof(hello));
+		host_packet_receive(&pkt);
+		task_wait_event(-1);
+	}
+	ccprintf("EC_CMD_HELLO: %d round trips in %lld us\n", rounds,
+		 (long long)(host_get_wall_time_us() - t0));
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < rounds; i++) {
+		hostcmd_fill_window(EC_CMD_READ_MEMMAP, &memmap,
+				    sizeof(memmap));
+		host_packet_receive(&pkt);
+		task_wait_event(-1);
+	}
+	ccprintf("EC_CMD_READ_MEMMAP (%d bytes): %d round trips in %lld us\n",
+		 memmap.size, rounds,
+		 (long long)(host_get_wall_time_us() - t0));
+
+	/* The same number of EC_CMD_HELLO, four per EC_CMD_BATCH */
+	memset(batch, 0, sizeof(struct ec_params_batch));
+	((struct ec_params_batch *)batch)->num_cmds = 4;
+	out = batch + sizeof(struct ec_params_batch);
+	for (i = 0; i < 4; i++)
+		out = hostcmd_batch_add(out, EC_CMD_HELLO,
+					&hello, sizeof(hello),
+					sizeof(struct ec_response_hello));
+
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < rounds / 4; i++) {
+		hostcmd_fill_window(EC_CMD_BATCH, batch, out - batch);
+		host_packet_receive(&pkt);
+		task_wait_event(-1);
+	}
+	ccprintf("EC_CMD_BATCH of 4 EC_CMD_HELLO: %d round trips in %lld us\n",
+		 rounds / 4, (long long)(host_get_wall_time_us() - t0));
+}
+
 void run_test(int argc, char **argv)
 {
 	wait_for_task_started();
@@ -315,6 +669,14 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_hostcmd_invalid_checksum);
 	RUN_TEST(test_hostcmd_reuse_response_buffer);
 	RUN_TEST(test_hostcmd_clears_unused_data);
+	RUN_TEST(test_hostcmd_in_place);
+	RUN_TEST(test_hostcmd_not_in_place);
+	RUN_TEST(test_hostcmd_stats);
+	RUN_TEST(test_hostcmd_resend_response);
+	RUN_TEST(test_hostcmd_batch);
+
+	/* do not check result, just as a benchmark */
+	test_hostcmd_speed();
 
 	test_print_result();
 }
@@ -6,11 +6,13 @@
  * Tests for keyboard scan deghosting and debouncing.
  */
 
+#include "chipset.h"
 #include "common.h"
 #include "console.h"
 #include "gpio.h"
 #include "hooks.h"
 #include "host_command.h"
+#include "host_test.h"
 #include "keyboard_raw.h"
 #include "keyboard_scan.h"
 #include "lid_switch.h"
@@ -24,6 +26,9 @@
 #define KEYDOWN_RETRY        10
 #define NO_KEYDOWN_DELAY_MS  100
 
+#define BENCH_SCANS          100000
+#define BENCH_KEYSTROKE_SCANS 16
+
 #define CHECK_KEY_COUNT(old, expected) \
 	do { \
 		if (verify_key_presses(old, expected) != EC_SUCCESS) \
@@ -33,6 +38,7 @@
 
 static uint8_t mock_state[KEYBOARD_COLS_MAX];
 static int column_driven;
+static int scan_count;
 static int fifo_add_count;
 static int lid_open;
 #ifdef EMU_BUILD
@@ -59,6 +65,8 @@ int lid_is_open(void)
 void keyboard_raw_drive_column(int out)
 {
 	column_driven = out;
+	if (out == 0)
+		scan_count++;
 }
 
 int keyboard_raw_read_rows(void)
@@ -89,7 +97,7 @@ void system_hibernate(uint32_t s, uint32_t us)
 	hibernated = 1;
 }
 
-void chipset_reset(void)
+void chipset_reset(enum chipset_reset_reason reason)
 {
 	reset_called = 1;
 }
@@ -98,6 +106,11 @@ void chipset_reset(void)
 #define mock_defined_key(k, p) mock_key(KEYBOARD_ROW_ ## k, \
 					KEYBOARD_COL_ ## k, \
 					p)
+#define mock_default_key(k, p) mock_key(KEYBOARD_DEFAULT_ROW_ ## k, \
+					KEYBOARD_DEFAULT_COL_ ## k, \
+					p)
+
+int check_keys_changed(uint8_t *state);
 
 static void mock_key(int r, int c, int keydown)
 {
@@ -304,6 +317,37 @@ static int simulate_key_test(void)
 	return EC_SUCCESS;
 }
 
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+static int adaptive_scan_test(void)
+{
+	struct keyboard_scan_config *config = keyboard_scan_get_config();
+	int scans;
+
+	msleep(40); /* Allow debounce to settle */
+
+	/* A held key is scanned at the longest period, not every period */
+	mock_key(1, 1, 1);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	msleep(40);
+	scans = scan_count;
+	msleep(240);
+	TEST_ASSERT(scan_count - scans <=
+		    240 / (CONFIG_KEYBOARD_SCAN_ADAPTIVE_MAX_PERIOD_US / MSEC)
+		    + 1);
+	TEST_ASSERT(scan_count - scans < 240 / (config->scan_period_us / MSEC));
+
+	/* Once released and debounced, scanning stops right away */
+	mock_key(1, 1, 0);
+	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
+	msleep(40);
+	scans = scan_count;
+	msleep(config->poll_timeout_us / MSEC);
+	TEST_ASSERT(scan_count == scans);
+
+	return EC_SUCCESS;
+}
+#endif
+
 #ifdef EMU_BUILD
 static int wait_variable_set(int *var)
 {
@@ -330,21 +374,21 @@ static int runtime_key_test(void)
 {
 	/* Alt-VolUp-H triggers system hibernation */
 	mock_defined_key(LEFT_ALT, 1);
-	mock_defined_key(VOL_UP, 1);
+	mock_default_key(VOL_UP, 1);
 	mock_defined_key(KEY_H, 1);
 	TEST_ASSERT(wait_variable_set(&hibernated) == EC_SUCCESS);
 	mock_defined_key(LEFT_ALT, 0);
-	mock_defined_key(VOL_UP, 0);
+	mock_default_key(VOL_UP, 0);
 	mock_defined_key(KEY_H, 0);
 	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
 
 	/* Alt-VolUp-R triggers chipset reset */
 	mock_defined_key(RIGHT_ALT, 1);
-	mock_defined_key(VOL_UP, 1);
+	mock_default_key(VOL_UP, 1);
 	mock_defined_key(KEY_R, 1);
 	TEST_ASSERT(wait_variable_set(&reset_called) == EC_SUCCESS);
 	mock_defined_key(RIGHT_ALT, 0);
-	mock_defined_key(VOL_UP, 0);
+	mock_default_key(VOL_UP, 0);
 	mock_defined_key(KEY_R, 0);
 	TEST_ASSERT(expect_keychange() == EC_SUCCESS);
 
@@ -352,10 +396,10 @@ static int runtime_key_test(void)
 	mock_defined_key(LEFT_ALT, 1);
 	mock_defined_key(KEY_H, 1);
 	mock_defined_key(KEY_R, 1);
-	mock_defined_key(VOL_UP, 1);
+	mock_default_key(VOL_UP, 1);
 	TEST_ASSERT(verify_variable_not_set(&hibernated) == EC_SUCCESS);
 	TEST_ASSERT(verify_variable_not_set(&reset_called) == EC_SUCCESS);
-	mock_defined_key(VOL_UP, 0);
+	mock_default_key(VOL_UP, 0);
 	mock_defined_key(KEY_R, 0);
 	mock_defined_key(KEY_H, 0);
 	mock_defined_key(LEFT_ALT, 0);
@@ -390,6 +434,53 @@ static int lid_test(void)
 }
 #endif
 
+/*
+ * Scan the mock matrix back to back while typing on it: one key held, another
+ * stroked with contact bounce on both edges, and a third rolling over the
+ * columns.  The settle delay is dropped and time is stepped one scan period
+ * per scan, so what is measured is the debounce and ghost handling.
+ */
+static int test_scan_speed(void)
+{
+	struct keyboard_scan_config *config = keyboard_scan_get_config();
+	uint16_t settle_us = config->output_settle_us;
+	uint8_t state[KEYBOARD_COLS_MAX] = { 0 };
+	timestamp_t t = get_time();
+	uint64_t start;
+	int i, phase, c;
+
+	config->output_settle_us = 0;
+	memset(mock_state, 0, sizeof(mock_state));
+	mock_state[0] = BIT(1);
+
+	start = host_get_wall_time_us();
+	for (i = 0; i < BENCH_SCANS; i++) {
+		phase = i % BENCH_KEYSTROKE_SCANS;
+		c = 1 + (i / BENCH_KEYSTROKE_SCANS) % (keyboard_cols - 1);
+
+		/* Bouncy stroke of (2, 3) */
+		if (phase < 3 || (phase >= 8 && phase < 11))
+			mock_state[3] ^= BIT(2);
+		else
+			mock_state[3] = (phase < 8) ? BIT(2) : 0;
+
+		/* Rolling stroke over the other columns */
+		if (c != 3)
+			mock_state[c] = (phase < 8) ? BIT(5) : 0;
+
+		t.val += config->scan_period_us;
+		force_time(t);
+		check_keys_changed(state);
+	}
+	ccprintf("%d scans: %lld us\n", BENCH_SCANS,
+		 (long long)(host_get_wall_time_us() - start));
+
+	memset(mock_state, 0, sizeof(mock_state));
+	config->output_settle_us = settle_us;
+
+	return EC_SUCCESS;
+}
+
 static int test_check_boot_esc(void)
 {
 	TEST_CHECK(keyboard_scan_get_boot_keys() == BOOT_KEY_ESC);
@@ -426,6 +517,9 @@ static void run_test_step1(void)
 	RUN_TEST(deghost_test);
 	RUN_TEST(debounce_test);
 	RUN_TEST(simulate_key_test);
+#ifdef CONFIG_KEYBOARD_SCAN_ADAPTIVE
+	RUN_TEST(adaptive_scan_test);
+#endif
 #ifdef EMU_BUILD
 	RUN_TEST(runtime_key_test);
 #endif
@@ -433,6 +527,9 @@ static void run_test_step1(void)
 	RUN_TEST(lid_test);
 #endif
 
+	/* do not check result, just as a benchmark */
+	test_scan_speed();
+
 	if (test_get_error_count())
 		test_reboot_to_next_step(TEST_STATE_FAILED);
 	else
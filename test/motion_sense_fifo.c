@@ -12,8 +12,14 @@
 #include "hwtimer.h"
 #include "timer.h"
 #include "accelgyro.h"
+#include "host_test.h"
 #include <sys/types.h>
 
+/* Mock sensor at 3.2kHz, interrupting at a 32 sample watermark */
+#define BENCH_ODR_PERIOD_US 312
+#define BENCH_WATERMARK 32
+#define BENCH_INTERRUPTS 20000
+
 struct motion_sensor_t motion_sensors[] = {
 	[BASE] = {},
 	[LID] = {},
@@ -343,6 +349,98 @@ static int test_commit_non_data_or_timestamp_entries(void)
 	return EC_SUCCESS;
 }
 
+static int test_stage_batch_matches_stage_data(void)
+{
+	static struct ec_response_motion_sensor_data expected[16];
+	const uint32_t now = __hw_clock_source_read();
+	int i, read_count;
+
+	motion_sensors[0].oversampling_ratio = 1;
+	motion_sensors[0].collection_rate = 20000; /* ns */
+	motion_sensors[1].oversampling_ratio = 1;
+	motion_sensors[1].collection_rate = 20000; /* ns */
+
+	for (i = 0; i < 4; i++) {
+		data[i].sensor_num = i & 1;
+		data[i].data[X] = i;
+		motion_sense_fifo_stage_data(&data[i], &motion_sensors[i & 1],
+					     3, now - 20500);
+	}
+	motion_sense_fifo_commit_data();
+	read_count = motion_sense_fifo_read(
+		sizeof(expected), ARRAY_SIZE(expected), expected,
+		&data_bytes_read);
+	TEST_EQ(read_count, 8, "%d");
+
+	motion_sense_fifo_reset();
+	for (i = 0; i < 4; i++)
+		motion_sense_fifo_batch_add(&data[i], now - 20500);
+	motion_sense_fifo_batch_stage();
+	motion_sense_fifo_commit_data();
+	read_count = motion_sense_fifo_read(
+		sizeof(data), CONFIG_ACCEL_FIFO_SIZE, data, &data_bytes_read);
+	TEST_EQ(read_count, 8, "%d");
+	TEST_ASSERT_ARRAY_EQ((uint8_t *)data, (uint8_t *)expected,
+			     8 * sizeof(*data));
+	TEST_EQ(motion_sensors[1].xyz[X], 3, "%d");
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Feed a mock high ODR sensor through the fifo, an interrupt's worth of
+ * samples at a time, and drain it as the AP would.  Only staging and
+ * committing, the motion sense task's share of the work, is timed.
+ */
+static void bench_fifo(const char *name, int batched)
+{
+	uint32_t now = __hw_clock_source_read();
+	uint64_t task_us = 0, t0;
+	int i, j;
+
+	motion_sense_fifo_reset();
+	motion_sensors[0].oversampling_ratio = 1;
+	motion_sensors[0].collection_rate = BENCH_ODR_PERIOD_US;
+
+	for (i = 0; i < BENCH_INTERRUPTS; i++) {
+		now += BENCH_ODR_PERIOD_US * BENCH_WATERMARK;
+
+		t0 = host_get_wall_time_us();
+		for (j = 0; j < BENCH_WATERMARK; j++) {
+			data[j].data[X] = j;
+			if (batched)
+				motion_sense_fifo_batch_add(&data[j], now);
+			else
+				motion_sense_fifo_stage_data(
+					&data[j], motion_sensors, 3, now);
+		}
+		if (batched)
+			motion_sense_fifo_batch_stage();
+		motion_sense_fifo_commit_data();
+		task_us += host_get_wall_time_us() - t0;
+
+		motion_sense_fifo_read(
+			sizeof(data) - BENCH_WATERMARK * sizeof(*data),
+			CONFIG_ACCEL_FIFO_SIZE, data + BENCH_WATERMARK,
+			&data_bytes_read);
+	}
+
+	ccprintf("%s: %d samples, task time %lld us, %lld samples/s\n",
+		 name, BENCH_INTERRUPTS * BENCH_WATERMARK,
+		 (long long)task_us,
+		 (long long)BENCH_INTERRUPTS * BENCH_WATERMARK * SECOND /
+			 MAX(task_us, 1));
+}
+
+static int test_fifo_throughput(void)
+{
+	memset(data, 0, sizeof(data));
+	bench_fifo("sample at a time", 0);
+	bench_fifo("batched", 1);
+
+	return EC_SUCCESS;
+}
+
 void before_test(void)
 {
 	motion_sense_fifo_commit_data();
@@ -372,6 +470,10 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_spread_data_by_collection_rate);
 	RUN_TEST(test_spread_double_commit_same_timestamp);
 	RUN_TEST(test_commit_non_data_or_timestamp_entries);
+	RUN_TEST(test_stage_batch_matches_stage_data);
+
+	/* do not check result, just as a benchmark */
+	test_fifo_throughput();
 
 	test_print_result();
 }
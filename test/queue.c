@@ -7,14 +7,19 @@
 
 #include "common.h"
 #include "console.h"
+#include "host_test.h"
 #include "queue.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <time.h>
 
 static struct queue const test_queue8 = QUEUE_NULL(8, char);
 static struct queue const test_queue2 = QUEUE_NULL(2, int16_t);
+static struct queue const test_queue_spsc = QUEUE_NULL(64, uint32_t);
+static struct queue const test_queue_bench = QUEUE_NULL(64, uint8_t);
 
 static int test_queue8_empty(void)
 {
@@ -324,6 +329,60 @@ static int test_queue8_chunks_offset(void)
 	return EC_SUCCESS;
 }
 
+static int test_queue8_chunks_scatter(void)
+{
+	struct queue const *q = &test_queue8;
+	static uint8_t const data[3] = {1, 2, 3};
+	struct queue_chunk chunks[2];
+
+	/* Empty: all the free space is in one chunk */
+	TEST_ASSERT(queue_get_read_chunks(q, chunks) == 0);
+	TEST_ASSERT(chunks[0].count == 0 && chunks[1].count == 0);
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 8);
+	TEST_ASSERT(chunks[0].count == 8 && chunks[1].count == 0);
+
+	/* Move near the end of the queue, and wrap the tail */
+	TEST_ASSERT(queue_advance_tail(q, 6) == 6);
+	TEST_ASSERT(queue_advance_head(q, 6) == 6);
+	TEST_ASSERT(queue_add_units(q, data, 3) == 3);
+
+	/* The units are split across the end of the buffer... */
+	TEST_ASSERT(queue_get_read_chunks(q, chunks) == 3);
+	TEST_ASSERT(chunks[0].count == 2 && chunks[1].count == 1);
+	TEST_ASSERT(chunks[0].buffer == q->buffer + 6);
+	TEST_ASSERT(chunks[1].buffer == q->buffer);
+	TEST_ASSERT(((uint8_t *)chunks[0].buffer)[0] == 1);
+	TEST_ASSERT(((uint8_t *)chunks[0].buffer)[1] == 2);
+	TEST_ASSERT(((uint8_t *)chunks[1].buffer)[0] == 3);
+
+	/* ...but the free space isn't */
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 5);
+	TEST_ASSERT(chunks[0].count == 5 && chunks[1].count == 0);
+	TEST_ASSERT(chunks[0].buffer == q->buffer + 1);
+
+	/* Read two, so the free space wraps instead */
+	TEST_ASSERT(queue_advance_head(q, 2) == 2);
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 7);
+	TEST_ASSERT(chunks[0].count == 7 && chunks[1].count == 0);
+	TEST_ASSERT(queue_advance_tail(q, 6) == 6);
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 1);
+	TEST_ASSERT(chunks[0].count == 1 && chunks[1].count == 0);
+	TEST_ASSERT(queue_advance_head(q, 5) == 5);
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 6);
+	TEST_ASSERT(chunks[0].count == 1 && chunks[1].count == 5);
+	TEST_ASSERT(chunks[0].buffer == q->buffer + 7);
+	TEST_ASSERT(chunks[1].buffer == q->buffer);
+
+	/* Full */
+	TEST_ASSERT(queue_advance_tail(q, 6) == 6);
+	TEST_ASSERT(queue_get_write_chunks(q, chunks) == 0);
+	TEST_ASSERT(chunks[0].count == 0 && chunks[1].count == 0);
+	TEST_ASSERT(queue_get_read_chunks(q, chunks) == 8);
+	TEST_ASSERT(chunks[0].count == 3 && chunks[1].count == 5);
+
+	return EC_SUCCESS;
+}
+
 static int test_queue8_iterate_begin(void)
 {
 	struct queue const *q = &test_queue8;
@@ -410,10 +469,172 @@ static int test_queue8_iterate_next_reset_on_change(void)
 	return EC_SUCCESS;
 }
 
+static int test_queue8_spsc(void)
+{
+	struct queue const *q = &test_queue8;
+	char data[8] = { -88, -37, -5, -1, 3, 16, 56, 100 };
+	char res[8];
+	char c;
+	int i;
+
+	/* Wrap around the end of the buffer */
+	TEST_ASSERT(queue_spsc_add_units(q, data, 6) == 6);
+	TEST_ASSERT(queue_spsc_remove_units(q, res, 5) == 5);
+	TEST_ASSERT_ARRAY_EQ(res, data, 5);
+
+	TEST_ASSERT(queue_spsc_add_units(q, data, 8) == 7);
+	TEST_ASSERT(queue_spsc_add_unit(q, data) == 0);
+	TEST_ASSERT(queue_is_full(q));
+
+	TEST_ASSERT(queue_spsc_remove_unit(q, &c) == 1);
+	TEST_ASSERT(c == data[5]);
+	for (i = 0; i < 7; i++) {
+		TEST_ASSERT(queue_spsc_remove_unit(q, &c) == 1);
+		TEST_ASSERT(c == data[i]);
+	}
+	TEST_ASSERT(queue_spsc_remove_units(q, res, 8) == 0);
+	TEST_ASSERT(queue_is_empty(q));
+
+	return EC_SUCCESS;
+}
+
+#define SPSC_STRESS_UNITS 20000
+
+/*
+ * Let the other side run: sched_yield() does not reliably give up the CPU
+ * when the test machine has a single one.
+ */
+static void spsc_wait(void)
+{
+	const struct timespec ts = { .tv_nsec = 1000 };
+
+	nanosleep(&ts, NULL);
+}
+
+/* Producer thread: adds 0, 1, 2, ... in chunks of varying size */
+static void *spsc_producer(void *arg)
+{
+	struct queue const *q = &test_queue_spsc;
+	uint32_t buf[5];
+	uint32_t next = 0, seed = 1;
+	size_t n, added, i;
+
+	while (next < SPSC_STRESS_UNITS) {
+		seed = prng(seed);
+		n = MIN((seed >> 16) % ARRAY_SIZE(buf) + 1,
+			SPSC_STRESS_UNITS - next);
+		for (i = 0; i < n; i++)
+			buf[i] = next + i;
+
+		if (n == 1)
+			added = queue_spsc_add_unit(q, buf);
+		else
+			added = queue_spsc_add_units(q, buf, n);
+		if (!added)
+			spsc_wait();
+		next += added;
+	}
+
+	return NULL;
+}
+
+/*
+ * Run a real producer thread against this task removing units: every unit
+ * must come out once, in order, with the data that went in.
+ */
+static int test_queue_spsc_stress(void)
+{
+	struct queue const *q = &test_queue_spsc;
+	pthread_t producer;
+	uint32_t buf[7];
+	uint32_t next = 0, seed = 2;
+	size_t n, removed, i;
+	uint64_t t0 = host_get_wall_time_us();
+
+	TEST_ASSERT(pthread_create(&producer, NULL, spsc_producer, NULL) == 0);
+
+	while (next < SPSC_STRESS_UNITS) {
+		seed = prng(seed);
+		n = (seed >> 16) % ARRAY_SIZE(buf) + 1;
+
+		if (n == 1)
+			removed = queue_spsc_remove_unit(q, buf);
+		else
+			removed = queue_spsc_remove_units(q, buf, n);
+		if (!removed)
+			spsc_wait();
+
+		for (i = 0; i < removed; i++)
+			TEST_EQ(buf[i], next + (uint32_t)i, "%u");
+		next += removed;
+	}
+
+	pthread_join(producer, NULL);
+	TEST_ASSERT(queue_is_empty(q));
+
+	ccprintf("%d units through the SPSC queue in %lld us\n",
+		 SPSC_STRESS_UNITS, (long long)(host_get_wall_time_us() - t0));
+
+	return EC_SUCCESS;
+}
+
+#define BENCH_BYTES (1 << 20)
+#define BENCH_PACKET 48
+
+/*
+ * Move BENCH_BYTES through a queue, in packets like a USB stream, either a
+ * byte at a time or a chunk at a time.
+ */
+static void test_queue_throughput(void)
+{
+	struct queue const *q = &test_queue_bench;
+	static uint8_t src[BENCH_PACKET], dst[64];
+	struct queue_chunk chunks[2];
+	size_t moved, n, i, j;
+	uint64_t t0;
+
+	for (i = 0; i < sizeof(src); i++)
+		src[i] = i;
+
+	queue_init(q);
+	t0 = host_get_wall_time_us();
+	for (moved = 0; moved < BENCH_BYTES; moved += n) {
+		for (i = 0; i < sizeof(src); i++)
+			if (!queue_add_unit(q, &src[i]))
+				break;
+		for (n = 0; queue_remove_unit(q, &dst[n % sizeof(dst)]); n++)
+			;
+	}
+	ccprintf("%d bytes a unit at a time: %lld us\n", BENCH_BYTES,
+		 (long long)(host_get_wall_time_us() - t0));
+
+	queue_init(q);
+	t0 = host_get_wall_time_us();
+	for (moved = 0; moved < BENCH_BYTES; moved += n) {
+		queue_get_write_chunks(q, chunks);
+		for (i = 0, n = 0; i < 2 && n < sizeof(src); i++) {
+			j = MIN(chunks[i].count, sizeof(src) - n);
+			memcpy(chunks[i].buffer, src + n, j);
+			n += j;
+		}
+		queue_advance_tail(q, n);
+
+		queue_get_read_chunks(q, chunks);
+		for (i = 0, n = 0; i < 2; i++) {
+			memcpy(dst + n, chunks[i].buffer, chunks[i].count);
+			n += chunks[i].count;
+		}
+		queue_advance_head(q, n);
+	}
+	ccprintf("%d bytes a chunk at a time: %lld us\n", BENCH_BYTES,
+		 (long long)(host_get_wall_time_us() - t0));
+}
+
 void before_test(void)
 {
 	queue_init(&test_queue2);
 	queue_init(&test_queue8);
+	queue_init(&test_queue_spsc);
 }
 
 void run_test(int argc, char **argv)
@@ -433,10 +654,16 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_queue8_chunks_empty);
 	RUN_TEST(test_queue8_chunks_advance);
 	RUN_TEST(test_queue8_chunks_offset);
+	RUN_TEST(test_queue8_chunks_scatter);
 	RUN_TEST(test_queue8_iterate_begin);
 	RUN_TEST(test_queue8_iterate_next);
 	RUN_TEST(test_queue2_iterate_next_full);
 	RUN_TEST(test_queue8_iterate_next_reset_on_change);
+	RUN_TEST(test_queue8_spsc);
+	RUN_TEST(test_queue_spsc_stress);
+
+	/* do not check result, just as a benchmark */
+	test_queue_throughput();
 
 	test_print_result();
 }
@@ -9,8 +9,13 @@
 #include "common.h"
 #include "sha256.h"
 #include "test_util.h"
+#include "timer.h"
 #include "util.h"
 
+#ifdef EMU_BUILD
+#include "host_test.h"
+#endif
+
 /* Short Msg from NIST FIPS 180-4 (Len = 8) */
 static const uint8_t sha256_8_input[] = {
 	0xd3
@@ -125,6 +130,9 @@ static const uint8_t hmac_medium_output[] = {
 	0xaa, 0x57, 0x17, 0x89, 0x6c, 0xb7, 0x0d, 0xdf
 };
 
+/* Scratch buffer for the unaligned test and the benchmark */
+static uint8_t bench_buf[4096];
+
 static int test_sha256(const uint8_t *input, int input_len,
 		       const uint8_t *output)
 {
@@ -142,6 +150,17 @@ static int test_sha256(const uint8_t *input, int input_len,
 		return 0;
 	}
 
+	/* Input that is not word aligned also works. */
+	memcpy(bench_buf + 1, input, input_len);
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, bench_buf + 1, input_len);
+	tmp = SHA256_final(&ctx);
+
+	if (memcmp(tmp, output, SHA256_DIGEST_SIZE) != 0) {
+		ccprintf("SHA256 test failed (unaligned)\n");
+		return 0;
+	}
+
 	/* Splitting the input string in chunks of 1 byte also works. */
 	SHA256_init(&ctx);
 	for (i = 0; i < input_len; i++)
@@ -156,6 +175,39 @@ static int test_sha256(const uint8_t *input, int input_len,
 	return 1;
 }
 
+static uint64_t bench_time_us(void)
+{
+#ifdef EMU_BUILD
+	/* Emulator time is virtual, so use the host clock. */
+	return host_get_wall_time_us();
+#else
+	return get_time().val;
+#endif
+}
+
+static void test_sha256_speed(void)
+{
+	const int rounds = 64;
+	struct sha256_ctx ctx;
+	uint64_t t0, dt;
+	int i;
+
+	for (i = 0; i < sizeof(bench_buf); i++)
+		bench_buf[i] = i;
+
+	t0 = bench_time_us();
+	SHA256_init(&ctx);
+	for (i = 0; i < rounds; i++)
+		SHA256_update(&ctx, bench_buf, sizeof(bench_buf));
+	SHA256_final(&ctx);
+	dt = MAX(bench_time_us() - t0, 1);
+
+	ccprintf("SHA256 %d bytes: %d us, %d KB/s\n",
+		 (int)(rounds * sizeof(bench_buf)), (int)dt,
+		 (int)((uint64_t)rounds * sizeof(bench_buf) * SECOND / 1024 /
+		       dt));
+}
+
 static int test_hmac(const uint8_t *key, int key_len,
 		     const uint8_t *input, int input_len,
 		     const uint8_t *output)
@@ -216,5 +268,8 @@ void run_test(int argc, char **argv)
 	 * 64 bytes keys.
 	 */
 
+	/* do not check result, just as a benchmark */
+	test_sha256_speed();
+
 	test_pass();
 }
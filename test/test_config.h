@@ -49,6 +49,15 @@
 #define CONFIG_MALLOC
 #endif
 
+#ifdef TEST_HOOKS_SORTED
+#define CONFIG_HOOK_SORTED_DISPATCH
+#endif
+
+/* Run the task switching tests on both host task backends */
+#if defined(TEST_PINGPONG_CORO) || defined(TEST_TIMER_DOS_CORO)
+#define CONFIG_HOST_TASK_COROUTINES
+#endif
+
 #ifdef TEST_KB_8042
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #endif
@@ -59,10 +68,14 @@
 #define CONFIG_MKBP_USE_GPIO
 #endif
 
-#ifdef TEST_KB_SCAN
+#if defined(TEST_KB_SCAN) || defined(TEST_KB_SCAN_ADAPTIVE)
 #define CONFIG_KEYBOARD_PROTOCOL_MKBP
 #define CONFIG_MKBP_EVENT
 #define CONFIG_MKBP_USE_GPIO
+
+#ifdef TEST_KB_SCAN_ADAPTIVE
+#define CONFIG_KEYBOARD_SCAN_ADAPTIVE
+#endif
 #endif
 
 #ifdef TEST_MATH_UTIL
@@ -219,8 +232,13 @@ enum sensor_id {
 
 #endif
 
-#ifdef TEST_CRC32
+#if defined(TEST_CRC32) || defined(TEST_CRC32_SLICES4)
 #define CONFIG_SW_CRC
+#ifdef TEST_CRC32_SLICES4
+#define CONFIG_SW_CRC_SLICES 4
+#else
+#define CONFIG_SW_CRC_SLICES 8
+#endif
 #endif
 
 #ifdef TEST_RSA
@@ -239,6 +257,15 @@ enum sensor_id {
 #define CONFIG_RWSIG_TYPE_RWSIG
 #endif
 
+#ifdef TEST_RSA_64BIT
+#define CONFIG_RSA
+#undef CONFIG_RSA_KEY_SIZE
+#define CONFIG_RSA_KEY_SIZE 2048
+#undef CONFIG_RSA_EXPONENT_3
+#define CONFIG_RSA_64BIT_LIMBS
+#define CONFIG_RWSIG_TYPE_RWSIG
+#endif
+
 #ifdef TEST_SHA256
 #define CONFIG_SHA256
 #endif
@@ -248,6 +275,12 @@ enum sensor_id {
 #define CONFIG_SHA256_UNROLLED
 #endif
 
+#ifdef TEST_SHA256_SHA_EXT
+#define CONFIG_SHA256
+#define CONFIG_SHA256_UNROLLED
+#define CONFIG_SHA256_X86_SHA_EXT
+#endif
+
 #ifdef TEST_SHMALLOC
 #define CONFIG_MALLOC
 #endif
@@ -315,6 +348,19 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_ALS_LIGHTBAR_DIMMING 0
 #endif
 
+#ifdef TEST_CONSOLE_TOKENS
+#define CONFIG_CONSOLE_TOKENIZED_LOG
+#undef CONFIG_CONSOLE_TOKENIZED_LOG_SIZE
+#define CONFIG_CONSOLE_TOKENIZED_LOG_SIZE 256
+#undef CONFIG_UART_TX_BUF_SIZE
+#define CONFIG_UART_TX_BUF_SIZE 32768
+#endif
+
+#ifdef TEST_UART_BUFFERING
+#undef CONFIG_UART_TX_BUF_SIZE
+#define CONFIG_UART_TX_BUF_SIZE 16384
+#endif
+
 #ifdef TEST_USB_COMMON
 #define CONFIG_USB_POWER_DELIVERY
 #define CONFIG_USB_PD_TCPMV1
@@ -352,7 +398,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_SW_CRC
 #endif
 
-#if defined(TEST_USB_PRL)
+#if defined(TEST_USB_PRL) || defined(TEST_USB_PRL_TICKLESS)
 #define CONFIG_USB_PD_PORT_MAX_COUNT 1
 #define CONFIG_USB_PD_REV30
 #define CONFIG_USB_PD_EXTENDED_MESSAGES
@@ -362,6 +408,10 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PD_HOST_CMD
 #define CONFIG_USB_PRL_SM
 #define CONFIG_USB_POWER_DELIVERY
+
+#ifdef TEST_USB_PRL_TICKLESS
+#define CONFIG_USB_PD_TICKLESS
+#endif
 #endif
 
 #if defined(TEST_USB_PE_DRP_OLD) || defined(TEST_USB_PE_DRP_OLD_NOEXTENDED)
@@ -388,7 +438,8 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_USBC_SS_MUX
 #endif
 
-#if defined(TEST_USB_PE_DRP) || defined(TEST_USB_PE_DRP_NOEXTENDED)
+#if defined(TEST_USB_PE_DRP) || defined(TEST_USB_PE_DRP_NOEXTENDED) || \
+	defined(TEST_USB_PE_DRP_TICKLESS)
 #define CONFIG_TEST_USB_PE_SM
 #define CONFIG_USB_PD_PORT_MAX_COUNT 1
 #define CONFIG_USB_PE_SM
@@ -397,10 +448,14 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PRL_SM
 #define CONFIG_USB_PD_REV30
 
-#if defined(TEST_USB_PE_DRP)
+#if defined(TEST_USB_PE_DRP) || defined(TEST_USB_PE_DRP_TICKLESS)
 #define CONFIG_USB_PD_EXTENDED_MESSAGES
 #endif
 
+#ifdef TEST_USB_PE_DRP_TICKLESS
+#define CONFIG_USB_PD_TICKLESS
+#endif
+
 #define CONFIG_USB_PD_TCPMV2
 #define CONFIG_USB_PD_DECODE_SOP
 #undef CONFIG_USB_TYPEC_SM
@@ -448,7 +503,8 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_USB_CTVPD
 #endif
 
-#ifdef TEST_USB_TYPEC_DRP_ACC_TRYSRC
+#if defined(TEST_USB_TYPEC_DRP_ACC_TRYSRC) || \
+	defined(TEST_USB_TYPEC_DRP_ACC_TRYSRC_TICKLESS)
 #define CONFIG_USB_DRP_ACC_TRYSRC
 #define CONFIG_USB_PD_DUAL_ROLE
 #define CONFIG_USB_PD_TRY_SRC
@@ -462,6 +518,10 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PRL_SM
 #undef CONFIG_USB_PE_SM
 #undef CONFIG_USB_PD_HOST_CMD
+
+#ifdef TEST_USB_TYPEC_DRP_ACC_TRYSRC_TICKLESS
+#define CONFIG_USB_PD_TICKLESS
+#endif
 #endif
 
 #ifdef TEST_USB_TCPMV2_TCPCI
@@ -559,6 +619,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 
 #ifdef TEST_VBOOT
 #define CONFIG_RWSIG
+#define CONFIG_CMD_RWSIG
 #define CONFIG_SHA256
 #define CONFIG_RSA
 #define CONFIG_RWSIG_TYPE_RWSIG
@@ -577,6 +638,20 @@ int ncp15wb_calculate_temp(uint16_t adc);
 					 CONFIG_RW_SIZE - CONFIG_RW_SIG_SIZE)
 #endif
 
+#if defined(TEST_VBOOT_HASH) || defined(TEST_VBOOT_HASH_SHMEM)
+#define CONFIG_VBOOT_HASH
+#define CONFIG_SHA256
+#undef CONFIG_VBOOT_HASH_CHUNKS_PER_CALL
+#define CONFIG_VBOOT_HASH_CHUNKS_PER_CALL 4
+#endif
+
+/* Read flash into shared memory to hash it, like SPI flash */
+#ifdef TEST_VBOOT_HASH_SHMEM
+#undef CONFIG_MAPPED_STORAGE
+#undef CONFIG_FLASH_PSTATE
+#undef CONFIG_FLASH_PSTATE_BANK
+#endif
+
 #ifdef TEST_X25519
 #define CONFIG_CURVE25519
 #endif /* TEST_X25519 */
@@ -588,5 +663,12 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define I2C_BITBANG_PORT_COUNT 1
 #endif
 
+#ifdef TEST_HOST_COMMAND
+#define CONFIG_HOSTCMD_INPLACE
+#define CONFIG_HOSTCMD_STATS
+#define CONFIG_HOST_COMMAND_STATUS
+#define CONFIG_HOSTCMD_BATCH
+#endif
+
 #endif  /* TEST_BUILD */
 #endif  /* __TEST_TEST_CONFIG_H */
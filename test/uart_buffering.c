@@ -0,0 +1,172 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests UART transmit buffering.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_test.h"
+#include "task.h"
+#include "test_util.h"
+#include "uart.h"
+#include "util.h"
+
+static char recent[CONFIG_UART_TX_BUF_SIZE + 1];
+
+/* Return what was written to the buffer since the previous call */
+static const char *read_recent(void)
+{
+	uint16_t count = 0;
+
+	uart_flush_output();
+	uart_console_read_buffer_init();
+	uart_console_read_buffer(CONSOLE_READ_RECENT, recent, sizeof(recent),
+				 &count);
+	return recent;
+}
+
+static int test_puts(void)
+{
+	read_recent();
+	TEST_ASSERT(uart_puts("one\ntwo\n\nthree") == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(read_recent(), "one\r\ntwo\r\n\r\nthree", 18);
+
+	TEST_ASSERT(uart_put_raw("a\nb", 3) == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(read_recent(), "a\nb", 4);
+
+	return EC_SUCCESS;
+}
+
+static int test_printf(void)
+{
+	static const char expect[] =
+		"lit abc 42|   xy|-7 |0x00ff\r\n\r\nend";
+
+	read_recent();
+	TEST_ASSERT(uart_printf("lit %s %d|%5s|%-3d|0x%04x\n\nend", "abc", 42,
+				"xy", -7, 0xff) == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(read_recent(), expect, sizeof(expect));
+
+	return EC_SUCCESS;
+}
+
+static int test_wrap(void)
+{
+	static char line[101];
+	static char expect[CONFIG_UART_TX_BUF_SIZE];
+	int total = 0;
+	int i, len;
+
+	read_recent();
+
+	/* Write more than the buffer holds, in pieces that straddle the end */
+	for (i = 0; total < CONFIG_UART_TX_BUF_SIZE * 3 / 2; i++) {
+		len = 1 + (i * 37) % 100;
+		memset(line, 'a' + i % 26, len);
+		line[len] = '\0';
+		TEST_ASSERT(uart_puts(line) == EC_SUCCESS);
+		uart_flush_output();
+		total += len;
+	}
+
+	/* Only the most recent output is still in the buffer */
+	read_recent();
+	len = strlen(recent);
+	TEST_EQ(len, CONFIG_UART_TX_BUF_SIZE - 1, "%d");
+	for (i--; len > 0; i--) {
+		int n = 1 + (i * 37) % 100;
+
+		while (n-- && len > 0)
+			expect[--len] = 'a' + i % 26;
+	}
+	TEST_ASSERT_ARRAY_EQ(recent, expect, CONFIG_UART_TX_BUF_SIZE - 1);
+
+	return EC_SUCCESS;
+}
+
+static int test_overflow(void)
+{
+	static char fill[CONFIG_UART_TX_BUF_SIZE];
+	int rv_put, full_put, rv_nl, full_nl, rv_printf;
+
+	memset(fill, '.', sizeof(fill));
+	uart_flush_output();
+
+	/*
+	 * Keep the buffer from draining while we fill it.  Nothing else may
+	 * print until it is enabled again.
+	 */
+	interrupt_disable();
+	rv_put = uart_put(fill, sizeof(fill) - 2);
+	full_put = uart_buffer_full();
+	rv_nl = uart_puts("\n");
+	full_nl = uart_buffer_full();
+	rv_printf = uart_printf("%d", 1);
+	interrupt_enable();
+
+	uart_flush_output();
+	TEST_EQ(rv_put, EC_SUCCESS, "%d");
+	TEST_EQ(full_put, 0, "%d");
+	TEST_EQ(rv_nl, EC_ERROR_OVERFLOW, "%d");
+	TEST_EQ(full_nl, 1, "%d");
+	TEST_EQ(rv_printf, EC_ERROR_OVERFLOW, "%d");
+	TEST_ASSERT(uart_buffer_empty());
+
+	return EC_SUCCESS;
+}
+
+static void test_output_speed(void)
+{
+	const int rounds = 2;
+	uint64_t printf_us = 0, cprints_us = 0, w0;
+	const int lines = CONFIG_UART_TX_BUF_SIZE / 64;
+	int i, n;
+
+	/*
+	 * Only time appending to the buffer; the emulated UART drains it to
+	 * stdout one character at a time.
+	 */
+	for (i = 0; i < rounds; i++) {
+		uart_flush_output();
+		interrupt_disable();
+		w0 = host_get_wall_time_us();
+		for (n = 0; n < lines; n++)
+			uart_printf("uart_printf %4d: %s 0x%08x\n", n,
+				    "some text", n * 0x10001);
+		printf_us += host_get_wall_time_us() - w0;
+		interrupt_enable();
+
+		uart_flush_output();
+		interrupt_disable();
+		w0 = host_get_wall_time_us();
+		for (n = 0; n < lines; n++)
+			cprints(CC_SYSTEM, "cprints %4d: %s 0x%08x", n,
+				"some text", n * 0x10001);
+		cprints_us += host_get_wall_time_us() - w0;
+		interrupt_enable();
+	}
+	uart_flush_output();
+
+	ccprintf("uart_printf: %d lines in %lld us\n", rounds * lines,
+		 (long long)printf_us);
+	ccprintf("cprints: %d lines in %lld us\n", rounds * lines,
+		 (long long)cprints_us);
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_puts);
+	RUN_TEST(test_printf);
+	RUN_TEST(test_wrap);
+	RUN_TEST(test_overflow);
+
+	/* do not check result, just as a benchmark */
+	test_output_speed();
+
+	test_print_result();
+}
@@ -49,7 +49,11 @@ void before_test(void)
 	task_wait_event(SECOND);
 }
 
-test_static int test_send_caps_error(void)
+/*
+ * Bring the PE up as a source with an explicit contract, answering its
+ * discovery requests with NOT_SUPPORTED, so that it settles in PE_SRC_Ready.
+ */
+static int setup_src_ready(void)
 {
 	/* Enable PE as source, expect SOURCE_CAP. */
 	mock_pd_port[PORT0].power_role = PD_ROLE_SOURCE;
@@ -101,6 +105,13 @@ test_static int test_send_caps_error(void)
 	fake_prl_message_received(PORT0);
 	task_wait_event(200 * MSEC);
 
+	return EC_SUCCESS;
+}
+
+test_static int test_send_caps_error(void)
+{
+	TEST_EQ(setup_src_ready(), EC_SUCCESS, "%d");
+
 	/*
 	 * Now connected. Send GET_SOURCE_CAP, to check how error sending
 	 * SOURCE_CAP is handled.
@@ -133,11 +144,74 @@ test_static int test_send_caps_error(void)
 	return EC_SUCCESS;
 }
 
+__maybe_unused test_static int test_ready_deadlines(void)
+{
+	/* A disabled PE doesn't need to run */
+	TEST_ASSERT(pe_get_next_deadline(PORT0) == SM_DEADLINE_NONE);
+
+	TEST_EQ(setup_src_ready(), EC_SUCCESS, "%d");
+
+	/* PE_SRC_Ready only waits for its timers or an event */
+	TEST_ASSERT(pe_get_next_deadline(PORT0) != SM_DEADLINE_POLL);
+	TEST_ASSERT(pe_get_next_deadline(PORT0) > get_time().val);
+
+	/* Answering GET_SOURCE_CAP leaves Ready, so the PE is polled */
+	rx_emsg[PORT0].header = PD_HEADER(PD_CTRL_GET_SOURCE_CAP, PD_ROLE_SINK,
+			PD_ROLE_UFP, 3,
+			0, PD_REV30, 0);
+	rx_emsg[PORT0].len = 0;
+	fake_prl_message_received(PORT0);
+	task_wait_event(10 * MSEC);
+	TEST_EQ(fake_prl_get_last_sent_data_msg_type(PORT0),
+		PD_DATA_SOURCE_CAP, "%d");
+	TEST_ASSERT(pe_get_next_deadline(PORT0) == SM_DEADLINE_POLL);
+
+	/* Waiting for the sink's REQUEST is still polled */
+	fake_prl_message_sent(PORT0);
+	task_wait_event(10 * MSEC);
+	TEST_ASSERT(pe_get_next_deadline(PORT0) == SM_DEADLINE_POLL);
+
+	/* Back in Ready once the new contract is in place */
+	rx_emsg[PORT0].header = PD_HEADER(PD_DATA_REQUEST, PD_ROLE_SINK,
+			PD_ROLE_UFP, 4,
+			1, PD_REV30, 0);
+	rx_emsg[PORT0].len = 4;
+	*(uint32_t *)rx_emsg[PORT0].buf = RDO_FIXED(1, 500, 500, 0);
+	fake_prl_message_received(PORT0);
+	task_wait_event(10 * MSEC);
+	TEST_EQ(fake_prl_get_last_sent_ctrl_msg(PORT0),
+		PD_CTRL_ACCEPT, "%d");
+	fake_prl_message_sent(PORT0);
+	task_wait_event(10 * MSEC);
+	TEST_EQ(fake_prl_get_last_sent_ctrl_msg(PORT0),
+		PD_CTRL_PS_RDY, "%d");
+	fake_prl_message_sent(PORT0);
+	task_wait_event(30 * MSEC);
+
+	/* Expect GET_SOURCE_CAP again, reply NOT_SUPPORTED. */
+	TEST_EQ(fake_prl_get_last_sent_ctrl_msg(PORT0),
+		PD_CTRL_GET_SOURCE_CAP, "%d");
+	fake_prl_message_sent(PORT0);
+	task_wait_event(10 * MSEC);
+	rx_emsg[PORT0].header = PD_HEADER(PD_CTRL_NOT_SUPPORTED, PD_ROLE_SINK,
+			PD_ROLE_UFP, 5,
+			0, PD_REV30, 0);
+	rx_emsg[PORT0].len = 0;
+	fake_prl_message_received(PORT0);
+	task_wait_event(200 * MSEC);
+	TEST_ASSERT(pe_get_next_deadline(PORT0) != SM_DEADLINE_POLL);
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, char **argv)
 {
 	test_reset();
 
 	RUN_TEST(test_send_caps_error);
+#ifdef CONFIG_USB_PD_TICKLESS
+	RUN_TEST(test_ready_deadlines);
+#endif
 
 	/* Do basic state machine validity checks last. */
 	RUN_TEST(test_pe_no_parent_cycles);
@@ -136,6 +136,26 @@ static int test_discard_queued_tx_when_rx_happens(void)
 	return EC_SUCCESS;
 }
 
+__maybe_unused static int test_next_deadline(void)
+{
+	int port = PORT0;
+
+	/* An idle protocol layer only runs on events */
+	TEST_ASSERT(prl_get_next_deadline(port) == SM_DEADLINE_NONE);
+
+	/* It is polled while a message is being sent */
+	prl_send_ctrl_msg(port, TCPC_TX_SOP, PD_CTRL_ACCEPT);
+	task_wait_event(MSEC);
+	TEST_ASSERT(prl_get_next_deadline(port) == SM_DEADLINE_POLL);
+
+	pd_transmit_complete(port, TCPC_TX_COMPLETE_SUCCESS);
+	task_wait_event(10*MSEC);
+	TEST_NE(mock_pe_port[port].mock_pe_message_sent, 0, "%d");
+	TEST_ASSERT(prl_get_next_deadline(port) == SM_DEADLINE_NONE);
+
+	return EC_SUCCESS;
+}
+
 void before_test(void)
 {
 	mock_tc_port_reset();
@@ -160,6 +180,9 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_receive_control_msg);
 	RUN_TEST(test_send_control_msg);
 	RUN_TEST(test_discard_queued_tx_when_rx_happens);
+#ifdef CONFIG_USB_PD_TICKLESS
+	RUN_TEST(test_next_deadline);
+#endif
 	/* TODO add tests here */
 
 
@@ -5,6 +5,7 @@
  * Test USB Type-C VPD and CTVPD module.
  */
 #include "common.h"
+#include "host_test.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -971,6 +972,31 @@ void before_test(void)
 	memset(&test_control, 0, sizeof(struct control));
 }
 
+#define BENCH_TRANSITIONS 1000000
+
+/* Go around the transitions of the diagram above, without running states */
+static void test_transition_speed(void)
+{
+	static const enum state cycle[] = {
+		SM_TEST_A4, SM_TEST_B4, SM_TEST_B5, SM_TEST_B6,
+		SM_TEST_C, SM_TEST_A7, SM_TEST_A6, SM_TEST_A5,
+	};
+	uint64_t t0, t;
+	int i;
+
+	before_test();
+	t0 = host_get_wall_time_us();
+	for (i = 0; i < BENCH_TRANSITIONS; i++) {
+		sm[PORT0].idx = 0;
+		set_state_sm(PORT0, cycle[i % ARRAY_SIZE(cycle)]);
+	}
+	t = host_get_wall_time_us() - t0;
+
+	ccprintf("%d transitions in %lld us, %lld per second\n",
+		 BENCH_TRANSITIONS, (long long)t,
+		 (long long)(BENCH_TRANSITIONS * 1000000ULL / MAX(t, 1)));
+}
+
 int test_task(void *u)
 {
 	int port = PORT0;
@@ -998,5 +1024,9 @@ void run_test(int argc, char **argv)
 #else
 	RUN_TEST(test_hierarchy_0);
 #endif
+
+	/* do not check result, just as a benchmark */
+	test_transition_speed();
+
 	test_print_result();
 }
@@ -722,6 +722,38 @@ __maybe_unused static int test_auto_toggle_delay_early_connect(void)
 	return EC_SUCCESS;
 }
 
+__maybe_unused static int test_tickless_idle_wakeups(void)
+{
+	mock_tcpc.should_print_call = false;
+
+	/* Attach a sink and let the port settle in Attached.SRC */
+	mock_tcpc.cc1 = TYPEC_CC_VOLT_RD;
+	mock_tcpc.cc2 = TYPEC_CC_VOLT_OPEN;
+	task_set_event(TASK_ID_PD_C0, PD_EVENT_CC, 0);
+	pd_set_dual_role(PORT0, PD_DRP_TOGGLE_ON);
+	task_wait_event(SECOND);
+	TEST_EQ(mock_usb_mux.state, USB_PD_MUX_USB_ENABLED, "%d");
+
+	/*
+	 * Attached.SRC checks CC once per state machine run, so this counts
+	 * task wakeups. Polling every 5 ms would be 12000 per minute.
+	 */
+	mock_tcpc.num_calls_to_get_cc = 0;
+	task_wait_event(MINUTE);
+	ccprintf("%d PD task wakeups per idle minute\n",
+		 mock_tcpc.num_calls_to_get_cc);
+	TEST_LE(mock_tcpc.num_calls_to_get_cc,
+		(int)(MINUTE / CONFIG_USB_PD_TICKLESS_MAX_SLEEP) + 1, "%d");
+
+	/* Detach is still noticed right away */
+	mock_tcpc.cc1 = TYPEC_CC_VOLT_OPEN;
+	task_set_event(TASK_ID_PD_C0, PD_EVENT_CC, 0);
+	task_wait_event(10 * SECOND);
+	TEST_EQ(mock_usb_mux.state, USB_PD_MUX_NONE, "%d");
+
+	return EC_SUCCESS;
+}
+
 /* TODO(b/153071799): test as SNK monitor for Vbus disconnect (not CC line) */
 /* TODO(b/153071799): test as SRC monitor for CC line state change */
 
@@ -773,6 +805,10 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_auto_toggle_delay);
 	RUN_TEST(test_auto_toggle_delay_early_connect);
 
+#ifdef CONFIG_USB_PD_TICKLESS
+	RUN_TEST(test_tickless_idle_wakeups);
+#endif
+
 	/* Do basic state machine validity checks last. */
 	RUN_TEST(test_tc_no_parent_cycles);
 	RUN_TEST(test_tc_all_states_named);
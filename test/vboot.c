@@ -6,6 +6,8 @@
  */
 
 #include "common.h"
+#include "ec_commands.h"
+#include "host_command.h"
 #include "rsa.h"
 #include "test_util.h"
 #include "vboot.h"
@@ -131,11 +133,36 @@ static int test_vboot(void)
 	return EC_SUCCESS;
 }
 
+static int test_rwsig_check_status(void)
+{
+	struct ec_response_rwsig_check_status_v1 r;
+	struct host_cmd_handler_args args = {
+		.command = EC_CMD_RWSIG_CHECK_STATUS,
+		.response = &r,
+		.response_max = sizeof(r),
+	};
+
+	/* Version 0 only reports the status */
+	args.version = 0;
+	TEST_EQ(host_command_process(&args), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(args.response_size ==
+		    sizeof(struct ec_response_rwsig_check_status));
+
+	/* Version 1 adds the time taken by that check */
+	args.version = 1;
+	TEST_EQ(host_command_process(&args), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(args.response_size == sizeof(r));
+	TEST_EQ(r.verify_time_us, rwsig_get_verify_time(), "%d");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, char **argv)
 {
 	test_reset();
 
 	RUN_TEST(test_vboot);
+	RUN_TEST(test_rwsig_check_status);
 
 	test_print_result();
 }
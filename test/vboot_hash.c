@@ -0,0 +1,220 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests vboot hash computation of the RW image.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "hooks.h"
+#include "host_test.h"
+#include "sha256.h"
+#include "shared_mem.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+#include "vboot_hash.h"
+
+#define RW_OFFSET (CONFIG_EC_WRITABLE_STORAGE_OFF + CONFIG_RW_STORAGE_OFF)
+
+static void fill_rw_image(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_RW_SIZE; i++)
+		__host_flash[RW_OFFSET + i] = (i * 7 + (i >> 8)) & 0xff;
+}
+
+static void wait_for_hash(void)
+{
+	while (vboot_hash_in_progress())
+		usleep(1000);
+}
+
+static int send_vboot_hash(uint8_t cmd, struct ec_response_vboot_hash *r)
+{
+	struct ec_params_vboot_hash p = {
+		.cmd = cmd,
+		.hash_type = EC_VBOOT_HASH_TYPE_SHA256,
+		.offset = RW_OFFSET,
+		.size = CONFIG_RW_SIZE,
+	};
+
+	return test_send_host_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p),
+				      r, sizeof(*r));
+}
+
+static int check_digest(const struct ec_response_vboot_hash *r)
+{
+	struct sha256_ctx ctx;
+	uint8_t *expect;
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, (const uint8_t *)__host_flash + RW_OFFSET,
+		      CONFIG_RW_SIZE);
+	expect = SHA256_final(&ctx);
+
+	TEST_EQ(r->status, EC_VBOOT_HASH_STATUS_DONE, "%d");
+	TEST_EQ(r->offset, RW_OFFSET, "%d");
+	TEST_EQ(r->size, CONFIG_RW_SIZE, "%d");
+	TEST_ASSERT_ARRAY_EQ(r->hash_digest, expect, SHA256_DIGEST_SIZE);
+
+	return EC_SUCCESS;
+}
+
+static int test_hash_deferred(void)
+{
+	struct ec_response_vboot_hash r;
+
+	wait_for_hash();
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_START, &r), EC_RES_SUCCESS,
+		"%d");
+	TEST_EQ(r.status, EC_VBOOT_HASH_STATUS_BUSY, "%d");
+
+	wait_for_hash();
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_GET, &r), EC_RES_SUCCESS, "%d");
+
+	return check_digest(&r);
+}
+
+static int test_hash_recalc(void)
+{
+	struct ec_response_vboot_hash r;
+
+	wait_for_hash();
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_RECALC, &r), EC_RES_SUCCESS,
+		"%d");
+
+	return check_digest(&r);
+}
+
+static int test_hash_invalidate(void)
+{
+	struct ec_response_vboot_hash r;
+
+	wait_for_hash();
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_RECALC, &r), EC_RES_SUCCESS,
+		"%d");
+	TEST_EQ(vboot_hash_invalidate(RW_OFFSET + CONFIG_RW_SIZE / 2, 1), 1,
+		"%d");
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_GET, &r), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.status, EC_VBOOT_HASH_STATUS_NONE, "%d");
+
+	return EC_SUCCESS;
+}
+
+#ifndef CONFIG_MAPPED_STORAGE
+/*
+ * Flash is read through shared memory; hold it to check that hashing waits
+ * for it, and gives up if it doesn't come back.
+ */
+static char *shmem_buf;
+
+/* From common/vboot_hash.c */
+int vboot_hash_start(uint32_t offset, uint32_t size, const uint8_t *nonce,
+		     int nonce_size, bool deferred);
+
+static void release_shmem(void)
+{
+	shared_mem_release(shmem_buf);
+}
+DECLARE_DEFERRED(release_shmem);
+
+static int test_hash_deferred_shmem_busy(void)
+{
+	struct ec_response_vboot_hash r;
+
+	wait_for_hash();
+	TEST_EQ(shared_mem_acquire(1, &shmem_buf), EC_SUCCESS, "%d");
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_START, &r), EC_RES_SUCCESS,
+		"%d");
+
+	/* No progress while shared memory is held */
+	usleep(20 * MSEC);
+	TEST_ASSERT(vboot_hash_in_progress());
+
+	shared_mem_release(shmem_buf);
+	wait_for_hash();
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_GET, &r), EC_RES_SUCCESS, "%d");
+
+	return check_digest(&r);
+}
+
+static int test_hash_blocking_shmem_busy(void)
+{
+	struct ec_response_vboot_hash r;
+
+	/* Shared memory comes back while the blocking hash waits for it */
+	wait_for_hash();
+	TEST_EQ(shared_mem_acquire(1, &shmem_buf), EC_SUCCESS, "%d");
+	hook_call_deferred(&release_shmem_data, 20 * MSEC);
+	TEST_EQ(vboot_hash_start(RW_OFFSET, CONFIG_RW_SIZE, NULL, 0, false),
+		EC_SUCCESS, "%d");
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_GET, &r), EC_RES_SUCCESS, "%d");
+
+	return check_digest(&r);
+}
+
+static int test_hash_blocking_shmem_timeout(void)
+{
+	struct ec_response_vboot_hash r;
+	timestamp_t t0;
+
+	wait_for_hash();
+	TEST_EQ(shared_mem_acquire(1, &shmem_buf), EC_SUCCESS, "%d");
+	t0 = get_time();
+	TEST_EQ(vboot_hash_start(RW_OFFSET, CONFIG_RW_SIZE, NULL, 0, false),
+		EC_SUCCESS, "%d");
+	shared_mem_release(shmem_buf);
+
+	/* Gave up after waiting, without a hash */
+	TEST_ASSERT(get_time().val - t0.val >= 100 * MSEC);
+	TEST_ASSERT(!vboot_hash_in_progress());
+	TEST_EQ(send_vboot_hash(EC_VBOOT_HASH_GET, &r), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.status, EC_VBOOT_HASH_STATUS_NONE, "%d");
+
+	return EC_SUCCESS;
+}
+#endif
+
+static void test_hash_speed(void)
+{
+	struct ec_response_vboot_hash r;
+	timestamp_t t0;
+	uint64_t w0;
+
+	wait_for_hash();
+	t0 = get_time();
+	w0 = host_get_wall_time_us();
+	send_vboot_hash(EC_VBOOT_HASH_START, &r);
+	wait_for_hash();
+
+	ccprintf("vboot hash %d bytes (%d chunks of %d per call): "
+		 "%lld us emulated, %lld us wall\n",
+		 CONFIG_RW_SIZE, CONFIG_VBOOT_HASH_CHUNKS_PER_CALL,
+		 CONFIG_VBOOT_HASH_CHUNK_SIZE,
+		 (long long)(get_time().val - t0.val),
+		 (long long)(host_get_wall_time_us() - w0));
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+	fill_rw_image();
+
+	RUN_TEST(test_hash_deferred);
+	RUN_TEST(test_hash_recalc);
+	RUN_TEST(test_hash_invalidate);
+#ifndef CONFIG_MAPPED_STORAGE
+	RUN_TEST(test_hash_deferred_shmem_busy);
+	RUN_TEST(test_hash_blocking_shmem_busy);
+	RUN_TEST(test_hash_blocking_shmem_timeout);
+#endif
+
+	/* do not check result, just as a benchmark */
+	test_hash_speed();
+
+	test_print_result();
+}
@@ -38,6 +38,10 @@
 #include "sha256.h"
 #include "util.h"
 
+#if defined(CONFIG_SHA256_X86_SHA_EXT) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
 #define ROTL(x, n)   ((x << n) | (x >> ((sizeof(x) << 3) - n)))
@@ -73,13 +77,34 @@
 			+ SHA256_F3(w[i - 15]) + w[i - 16];	\
 	}
 
-#define SHA256_EXP(a, b, c, d, e, f, g, h, j)				\
+/*
+ * Fully unrolled rounds: the working variables are renamed by rotating the
+ * macro arguments instead of being shifted, and the message schedule is kept
+ * in a rolling 16-word window that is expanded in place as rounds consume it.
+ */
+#define SHA256_W_LOAD(i) (w[i])
+#define SHA256_W_EXP(i)							\
+	(w[(i) & 15] += SHA256_F4(w[((i) - 2) & 15]) + w[((i) - 7) & 15]	\
+			+ SHA256_F3(w[((i) - 15) & 15]))
+
+#define SHA256_RND(a, b, c, d, e, f, g, h, i, W)			\
+	{								\
+		t1 = h + SHA256_F2(e) + CH(e, f, g) + sha256_k[i] + W(i);\
+		t2 = SHA256_F1(a) + MAJ(a, b, c);			\
+		d += t1;						\
+		h = t1 + t2;						\
+	}
+
+#define SHA256_RND8(i, W)						\
 	{								\
-		t1 = wv[h] + SHA256_F2(wv[e]) + CH(wv[e], wv[f], wv[g])	\
-			+ sha256_k[j] + w[j];				\
-		t2 = SHA256_F1(wv[a]) + MAJ(wv[a], wv[b], wv[c]);	\
-		wv[d] += t1;						\
-		wv[h] = t1 + t2;					\
+		SHA256_RND(a, b, c, d, e, f, g, h, (i) + 0, W);		\
+		SHA256_RND(h, a, b, c, d, e, f, g, (i) + 1, W);		\
+		SHA256_RND(g, h, a, b, c, d, e, f, (i) + 2, W);		\
+		SHA256_RND(f, g, h, a, b, c, d, e, (i) + 3, W);		\
+		SHA256_RND(e, f, g, h, a, b, c, d, (i) + 4, W);		\
+		SHA256_RND(d, e, f, g, h, a, b, c, (i) + 5, W);		\
+		SHA256_RND(c, d, e, f, g, h, a, b, (i) + 6, W);		\
+		SHA256_RND(b, c, d, e, f, g, h, a, (i) + 7, W);		\
 	}
 
 static const uint32_t sha256_h0[8] = {
@@ -115,8 +140,65 @@ void SHA256_init(struct sha256_ctx *ctx)
 	ctx->tot_len = 0;
 }
 
-static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
-			     unsigned int block_nb)
+#ifdef CONFIG_SHA256_UNROLLED
+
+/* Load a big-endian word from a possibly unaligned pointer */
+static inline uint32_t load_be32(const uint8_t *p)
+{
+	uint32_t x;
+
+	__builtin_memcpy(&x, p, sizeof(x));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	x = __builtin_bswap32(x);
+#endif
+	return x;
+}
+
+static void SHA256_transform_c(struct sha256_ctx *ctx, const uint8_t *message,
+			       unsigned int block_nb)
+{
+	uint32_t w[16];
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t t1, t2;
+	int j;
+
+	for (; block_nb; block_nb--, message += SHA256_BLOCK_SIZE) {
+		for (j = 0; j < 16; j++)
+			w[j] = load_be32(message + (j << 2));
+
+		a = ctx->h[0];
+		b = ctx->h[1];
+		c = ctx->h[2];
+		d = ctx->h[3];
+		e = ctx->h[4];
+		f = ctx->h[5];
+		g = ctx->h[6];
+		h = ctx->h[7];
+
+		SHA256_RND8(0, SHA256_W_LOAD);
+		SHA256_RND8(8, SHA256_W_LOAD);
+		SHA256_RND8(16, SHA256_W_EXP);
+		SHA256_RND8(24, SHA256_W_EXP);
+		SHA256_RND8(32, SHA256_W_EXP);
+		SHA256_RND8(40, SHA256_W_EXP);
+		SHA256_RND8(48, SHA256_W_EXP);
+		SHA256_RND8(56, SHA256_W_EXP);
+
+		ctx->h[0] += a;
+		ctx->h[1] += b;
+		ctx->h[2] += c;
+		ctx->h[3] += d;
+		ctx->h[4] += e;
+		ctx->h[5] += f;
+		ctx->h[6] += g;
+		ctx->h[7] += h;
+	}
+}
+
+#else /* !CONFIG_SHA256_UNROLLED */
+
+static void SHA256_transform_c(struct sha256_ctx *ctx, const uint8_t *message,
+			       unsigned int block_nb)
 {
 	/* Note: this function requires a considerable amount of stack */
 	uint32_t w[64];
@@ -131,37 +213,12 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 		for (j = 0; j < 16; j++)
 			PACK32(&sub_block[j << 2], &w[j]);
 
-#ifdef CONFIG_SHA256_UNROLLED
-		for (j = 16; j < 64; j += 8) {
-			SHA256_SCR(j);
-			SHA256_SCR(j+1);
-			SHA256_SCR(j+2);
-			SHA256_SCR(j+3);
-			SHA256_SCR(j+4);
-			SHA256_SCR(j+5);
-			SHA256_SCR(j+6);
-			SHA256_SCR(j+7);
-		}
-#else
 		for (j = 16; j < 64; j++)
 			SHA256_SCR(j);
-#endif
 
 		for (j = 0; j < 8; j++)
 			wv[j] = ctx->h[j];
 
-#ifdef CONFIG_SHA256_UNROLLED
-		for (j = 0; j < 64; j += 8) {
-			SHA256_EXP(0, 1, 2, 3, 4, 5, 6, 7, j);
-			SHA256_EXP(7, 0, 1, 2, 3, 4, 5, 6, j+1);
-			SHA256_EXP(6, 7, 0, 1, 2, 3, 4, 5, j+2);
-			SHA256_EXP(5, 6, 7, 0, 1, 2, 3, 4, j+3);
-			SHA256_EXP(4, 5, 6, 7, 0, 1, 2, 3, j+4);
-			SHA256_EXP(3, 4, 5, 6, 7, 0, 1, 2, j+5);
-			SHA256_EXP(2, 3, 4, 5, 6, 7, 0, 1, j+6);
-			SHA256_EXP(1, 2, 3, 4, 5, 6, 7, 0, j+7);
-		}
-#else
 		for (j = 0; j < 64; j++) {
 			t1 = wv[7] + SHA256_F2(wv[4]) + CH(wv[4], wv[5], wv[6])
 				+ sha256_k[j] + w[j];
@@ -175,13 +232,97 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 			wv[1] = wv[0];
 			wv[0] = t1 + t2;
 		}
-#endif
 
 		for (j = 0; j < 8; j++)
 			ctx->h[j] += wv[j];
 	}
 }
 
+#endif /* CONFIG_SHA256_UNROLLED */
+
+#if defined(CONFIG_SHA256_X86_SHA_EXT) && defined(__x86_64__)
+
+/*
+ * x86 SHA extensions. Each SHA256RNDS2 performs two rounds on the state held
+ * as ABEF/CDGH register pairs; SHA256MSG1/2 expand four schedule words at a
+ * time.
+ */
+__attribute__((target("sha,sse4.1")))
+static void SHA256_transform_sha_ext(struct sha256_ctx *ctx,
+				     const uint8_t *message,
+				     unsigned int block_nb)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					     0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg, tmp;
+	__m128i w[4];
+	int i;
+
+	tmp = _mm_loadu_si128((const __m128i *)&ctx->h[0]);
+	state1 = _mm_loadu_si128((const __m128i *)&ctx->h[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xb1);		/* CDAB */
+	state1 = _mm_shuffle_epi32(state1, 0x1b);	/* EFGH */
+	state0 = _mm_alignr_epi8(tmp, state1, 8);	/* ABEF */
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);	/* CDGH */
+
+	for (; block_nb; block_nb--, message += SHA256_BLOCK_SIZE) {
+		abef = state0;
+		cdgh = state1;
+
+		for (i = 0; i < 4; i++)
+			w[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+				(const __m128i *)(message + 16 * i)), bswap);
+
+		/* w[i & 3] holds schedule words 4i..4i+3 during group i */
+		for (i = 0; i < 16; i++) {
+			if (i >= 4) {
+				tmp = _mm_sha256msg1_epu32(w[i & 3],
+							   w[(i + 1) & 3]);
+				tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(
+					w[(i + 3) & 3], w[(i + 2) & 3], 4));
+				w[i & 3] = _mm_sha256msg2_epu32(tmp,
+								w[(i + 3) & 3]);
+			}
+			msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128(
+				(const __m128i *)&sha256_k[4 * i]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+			msg = _mm_shuffle_epi32(msg, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		}
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);		/* FEBA */
+	state1 = _mm_shuffle_epi32(state1, 0xb1);	/* DCHG */
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);	/* DCBA */
+	state1 = _mm_alignr_epi8(state1, tmp, 8);	/* HGFE */
+
+	_mm_storeu_si128((__m128i *)&ctx->h[0], state0);
+	_mm_storeu_si128((__m128i *)&ctx->h[4], state1);
+}
+
+static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
+			     unsigned int block_nb)
+{
+	static int has_sha_ext = -1;
+
+	if (has_sha_ext < 0)
+		has_sha_ext = !!__builtin_cpu_supports("sha");
+
+	if (has_sha_ext)
+		SHA256_transform_sha_ext(ctx, message, block_nb);
+	else
+		SHA256_transform_c(ctx, message, block_nb);
+}
+
+#else
+
+#define SHA256_transform SHA256_transform_c
+
+#endif /* CONFIG_SHA256_X86_SHA_EXT && __x86_64__ */
+
 void SHA256_update(struct sha256_ctx *ctx, const uint8_t *data, uint32_t len)
 {
 	unsigned int block_nb;
@@ -83,6 +83,151 @@ int ec_command(int command, int version,
 				indata, insize);
 }
 
+/* Send the commands one at a time, for ECs without EC_CMD_BATCH */
+static void ec_command_batch_serial(struct ec_batch_cmd *cmds, int num_cmds)
+{
+	for (; num_cmds > 0; cmds++, num_cmds--)
+		cmds->rv = ec_command(cmds->command, cmds->version,
+				      cmds->outdata, cmds->outsize,
+				      cmds->indata, cmds->insize);
+}
+
+/*
+ * Pack as many commands as fit in one EC_CMD_BATCH request and its response.
+ * Returns the number of commands packed and the request and maximum response
+ * sizes.
+ */
+static int ec_command_batch_pack(const struct ec_batch_cmd *cmds, int num_cmds,
+				 struct ec_params_batch *p,
+				 int *outsize, int *insize)
+{
+	uint8_t *out = (uint8_t *)(p + 1);
+	int n;
+
+	*outsize = sizeof(*p);
+	*insize = sizeof(struct ec_response_batch);
+
+	for (n = 0; n < num_cmds && n < UINT8_MAX; n++) {
+		struct ec_batch_request *req = (struct ec_batch_request *)out;
+		int req_size = sizeof(*req) + EC_BATCH_ALIGN(cmds[n].outsize);
+		int resp_size = sizeof(struct ec_batch_response) +
+				EC_BATCH_ALIGN(cmds[n].insize);
+
+		if (*outsize + req_size > ec_max_outsize ||
+		    *insize + resp_size > ec_max_insize)
+			break;
+
+		memset(req, 0, req_size);
+		req->command = cmds[n].command;
+		req->version = cmds[n].version;
+		req->params_size = cmds[n].outsize;
+		req->response_max = cmds[n].insize;
+		if (cmds[n].outsize)
+			memcpy(req + 1, cmds[n].outdata, cmds[n].outsize);
+
+		out += req_size;
+		*outsize += req_size;
+		*insize += resp_size;
+	}
+
+	memset(p, 0, sizeof(*p));
+	p->num_cmds = n;
+	return n;
+}
+
+/*
+ * Copy the results of a batch back to its commands.  Returns the number of
+ * commands the EC ran, or negative if the response is malformed.
+ */
+static int ec_command_batch_unpack(struct ec_batch_cmd *cmds, int num_cmds,
+				   const struct ec_response_batch *r, int size)
+{
+	const uint8_t *in = (const uint8_t *)(r + 1);
+	const uint8_t *end = (const uint8_t *)r + size;
+	int i;
+
+	if (size < sizeof(*r) || r->num_cmds == 0 || r->num_cmds > num_cmds)
+		return -EECRESULT - EC_RES_INVALID_RESPONSE;
+
+	for (i = 0; i < r->num_cmds; i++) {
+		const struct ec_batch_response *resp =
+			(const struct ec_batch_response *)in;
+		int len;
+
+		if (end - in < (int)sizeof(*resp) ||
+		    end - in - (int)sizeof(*resp) < resp->response_size)
+			return -EECRESULT - EC_RES_INVALID_RESPONSE;
+
+		if (resp->result) {
+			cmds[i].rv = -EECRESULT - resp->result;
+		} else {
+			len = MIN(resp->response_size, cmds[i].insize);
+			if (len)
+				memcpy(cmds[i].indata, resp + 1, len);
+			cmds[i].rv = len;
+		}
+
+		in += sizeof(*resp) + EC_BATCH_ALIGN(resp->response_size);
+	}
+
+	return r->num_cmds;
+}
+
+int ec_command_batch(struct ec_batch_cmd *cmds, int num_cmds)
+{
+	static bool batch_unsupported;
+	struct ec_params_batch *p;
+	struct ec_response_batch *r;
+	int n, outsize, insize, rv = 0;
+
+	if (batch_unsupported) {
+		ec_command_batch_serial(cmds, num_cmds);
+		return 0;
+	}
+
+	p = malloc(ec_max_outsize);
+	r = malloc(ec_max_insize);
+	if (!p || !r) {
+		fprintf(stderr, "Unable to allocate buffers\n");
+		rv = -1;
+		goto out;
+	}
+
+	while (num_cmds > 0) {
+		n = ec_command_batch_pack(cmds, num_cmds, p, &outsize, &insize);
+		if (n == 0) {
+			/* Too big to share a request with anything */
+			ec_command_batch_serial(cmds, 1);
+			cmds++;
+			num_cmds--;
+			continue;
+		}
+
+		rv = ec_command(EC_CMD_BATCH, 0, p, outsize, r, insize);
+		if (rv == -EECRESULT - EC_RES_INVALID_COMMAND) {
+			batch_unsupported = true;
+			ec_command_batch_serial(cmds, num_cmds);
+			rv = 0;
+			break;
+		}
+		if (rv < 0)
+			break;
+
+		rv = ec_command_batch_unpack(cmds, n, r, rv);
+		if (rv < 0)
+			break;
+
+		cmds += rv;
+		num_cmds -= rv;
+		rv = 0;
+	}
+
+out:
+	free(p);
+	free(r);
+	return rv;
+}
+
 int comm_init_alt(int interfaces, const char *device_name, int i2c_bus)
 {
 	bool dev_is_cros_ec;
@@ -66,6 +66,25 @@ int ec_command(int command, int version,
 	       const void *outdata, int outsize,   /* to the EC */
 	       void *indata, int insize);	   /* from the EC */
 
+/* A command sent with ec_command_batch() */
+struct ec_batch_cmd {
+	int command;
+	int version;
+	const void *outdata;	/* to the EC */
+	int outsize;
+	void *indata;		/* from the EC */
+	int insize;
+	int rv;			/* Set to what ec_command() would return */
+};
+
+/**
+ * Send several commands to the EC, packed into as few EC_CMD_BATCH requests
+ * as fit, or one at a time if the EC doesn't support EC_CMD_BATCH.  Sets the
+ * rv of each command.  Returns 0, or negative if a batch failed as a whole;
+ * then the commands from that batch on have no rv.
+ */
+int ec_command_batch(struct ec_batch_cmd *cmds, int num_cmds);
+
 /**
  * Set the offset to be applied to the command number when ec_command() calls
  * ec_command_proto().
@@ -8,15 +8,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "comm-host.h"
+#include "ec_flash.h"
 #include "misc_util.h"
+#include "sha256.h"
 #include "timer.h"
 
 static const uint32_t ERASE_ASYNC_TIMEOUT = 10 * SECOND;
 static const uint32_t ERASE_ASYNC_WAIT = 500 * MSEC;
 static const int FLASH_ERASE_BUSY_RV = -EECRESULT - EC_RES_BUSY;
 
+/* Size of the ranges compared by hash before falling back to reading */
+#define VERIFY_HASH_SIZE (32 * 1024)
+
 int ec_flash_read(uint8_t *buf, int offset, int size)
 {
 	struct ec_params_flash_read p;
@@ -28,48 +34,133 @@ int ec_flash_read(uint8_t *buf, int offset, int size)
 		p.offset = offset + i;
 		p.size = MIN(size - i, ec_max_insize);
 		rv = ec_command(EC_CMD_FLASH_READ, 0,
-				&p, sizeof(p), ec_inbuf, p.size);
+				&p, sizeof(p), buf + i, p.size);
 		if (rv < 0) {
 			fprintf(stderr, "Read error at offset %d\n", i);
 			return rv;
 		}
-		memcpy(buf + i, ec_inbuf, p.size);
 	}
 
 	return 0;
 }
 
-int ec_flash_verify(const uint8_t *buf, int offset, int size)
+int ec_flash_hash_match(const uint8_t *buf, int offset, int size)
 {
-	uint8_t *rbuf = malloc(size);
+	struct ec_params_vboot_hash p = { 0 };
+	struct ec_response_vboot_hash r;
+	struct sha256_ctx ctx;
 	int rv;
-	int i;
 
-	if (!rbuf) {
-		fprintf(stderr, "Unable to allocate buffer.\n");
-		return -1;
-	}
+	p.cmd = EC_VBOOT_HASH_RECALC;
+	p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	p.offset = offset;
+	p.size = size;
 
-	rv = ec_flash_read(rbuf, offset, size);
-	if (rv < 0) {
-		free(rbuf);
+	rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p), &r, sizeof(r));
+	if (rv < 0)
 		return rv;
-	}
 
-	for (i = 0; i < size; i++) {
-		if (buf[i] != rbuf[i]) {
-			fprintf(stderr, "Mismatch at offset 0x%x: "
-				"want 0x%02x, got 0x%02x\n",
-				i, buf[i], rbuf[i]);
-			free(rbuf);
-			return -1;
+	if (r.status != EC_VBOOT_HASH_STATUS_DONE ||
+	    r.hash_type != EC_VBOOT_HASH_TYPE_SHA256 ||
+	    r.digest_size != SHA256_DIGEST_SIZE ||
+	    r.offset != offset || r.size != size)
+		return -1;
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, buf, size);
+
+	return !memcmp(SHA256_final(&ctx), r.hash_digest, SHA256_DIGEST_SIZE);
+}
+
+int ec_flash_hash_restore(void)
+{
+	struct ec_params_vboot_hash p = { 0 };
+	struct ec_response_vboot_hash r;
+	int rv;
+
+	p.cmd = EC_VBOOT_HASH_START;
+	p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	p.offset = EC_VBOOT_HASH_OFFSET_ACTIVE;
+
+	rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p), &r, sizeof(r));
+
+	return rv < 0 ? rv : 0;
+}
+
+/**
+ * Read back a range of EC flash and compare it to buf, one packet at a time.
+ *
+ * @param base		Offset of buf within the region being verified, only
+ *			used to report mismatches.
+ */
+static int verify_stream(const uint8_t *buf, int offset, int size, int base)
+{
+	struct ec_params_flash_read p;
+	int rv;
+	int i, j;
+
+	for (i = 0; i < size; i += ec_max_insize) {
+		p.offset = offset + i;
+		p.size = MIN(size - i, ec_max_insize);
+		rv = ec_command(EC_CMD_FLASH_READ, 0,
+				&p, sizeof(p), ec_inbuf, p.size);
+		if (rv < 0) {
+			fprintf(stderr, "Read error at offset %d\n",
+				base + i);
+			return rv;
+		}
+
+		if (!memcmp(buf + i, ec_inbuf, p.size))
+			continue;
+
+		for (j = 0; j < p.size; j++) {
+			if (buf[i + j] != ((uint8_t *)ec_inbuf)[j]) {
+				fprintf(stderr, "Mismatch at offset 0x%x: "
+					"want 0x%02x, got 0x%02x\n",
+					base + i + j, buf[i + j],
+					((uint8_t *)ec_inbuf)[j]);
+				return -1;
+			}
 		}
 	}
 
-	free(rbuf);
 	return 0;
 }
 
+int ec_flash_verify(const uint8_t *buf, int offset, int size)
+{
+	int use_hash = 1;
+	int rv = 0;
+	int i;
+
+	/*
+	 * Let the EC hash each range and only read back the ranges whose
+	 * hash does not match, which saves most of the round trips when
+	 * the image is correct.
+	 */
+	for (i = 0; i < size; i += VERIFY_HASH_SIZE) {
+		int len = MIN(size - i, VERIFY_HASH_SIZE);
+
+		if (use_hash) {
+			rv = ec_flash_hash_match(buf + i, offset + i, len);
+			if (rv > 0)
+				continue;
+			/* Don't retry if the EC can't hash at all */
+			if (rv == -EECRESULT - EC_RES_INVALID_COMMAND)
+				use_hash = 0;
+		}
+
+		rv = verify_stream(buf + i, offset + i, len, i);
+		if (rv < 0)
+			break;
+	}
+
+	if (use_hash)
+		ec_flash_hash_restore();
+
+	return rv < 0 ? rv : 0;
+}
+
 /**
  * @param info_response  pointer to response that will be filled on success
  * @return Zero or positive on success, negative on failure
@@ -186,6 +277,115 @@ int ec_flash_write(const uint8_t *buf, int offset, int size)
 	return 0;
 }
 
+/**
+ * @return Erase block size on success, negative on failure
+ */
+static int get_flash_erase_size(void)
+{
+	struct ec_response_flash_info info = { 0 };
+	int rv;
+
+	rv = get_flash_info_v0(&info);
+	if (rv < 0)
+		return rv;
+
+	return info.erase_block_size;
+}
+
+static uint64_t monotonic_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Erase then write one run of erase blocks.
+ */
+static int write_run(const uint8_t *buf, int offset, int size)
+{
+	int rv;
+
+	rv = ec_flash_erase(offset, size);
+	if (rv < 0) {
+		fprintf(stderr, "Erase error at offset %d\n", offset);
+		return rv;
+	}
+
+	return ec_flash_write(buf, offset, size);
+}
+
+int ec_flash_write_diff(const uint8_t *buf, int offset, int size)
+{
+	uint64_t start = monotonic_ms();
+	int erase_size;
+	int use_hash = 1;
+	int run_start = -1;  /* Start of the current run of changed blocks */
+	int written = 0;
+	int rv = 0;
+	int i;
+
+	erase_size = get_flash_erase_size();
+	if (erase_size <= 0) {
+		fprintf(stderr, "Unable to get erase block size\n");
+		return -1;
+	}
+
+	if (offset % erase_size || size % erase_size) {
+		fprintf(stderr, "Offset and size must be multiples of the "
+			"erase block size %d\n", erase_size);
+		return -1;
+	}
+
+	/*
+	 * Compare each erase block against its EC-side hash, and erase and
+	 * write runs of consecutive mismatching blocks together.
+	 */
+	for (i = 0; i <= size; i += erase_size) {
+		int changed = 0;
+
+		if (i < size) {
+			changed = 1;
+			if (use_hash) {
+				rv = ec_flash_hash_match(buf + i, offset + i,
+							 erase_size);
+				if (rv > 0)
+					changed = 0;
+				else if (rv < 0 && !i)
+					use_hash = 0;
+			}
+		}
+
+		if (changed) {
+			if (run_start < 0)
+				run_start = i;
+			continue;
+		}
+
+		if (run_start < 0)
+			continue;
+
+		rv = write_run(buf + run_start, offset + run_start,
+			       i - run_start);
+		if (rv < 0)
+			break;
+		written += i - run_start;
+		run_start = -1;
+	}
+
+	if (use_hash)
+		ec_flash_hash_restore();
+	if (rv < 0)
+		return rv;
+
+	printf("Wrote %d of %d bytes (%d bytes saved) in %d ms\n",
+	       written, size, size - written,
+	       (int)(monotonic_ms() - start));
+
+	return 0;
+}
+
 int ec_flash_erase(int offset, int size)
 {
 	struct ec_params_flash_erase p;
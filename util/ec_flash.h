@@ -20,6 +20,9 @@ int ec_flash_read(uint8_t *buf, int offset, int size);
 /**
  * Verify EC flash memory
  *
+ * Ranges whose EC-side hash matches are skipped, the rest is read back and
+ * compared one packet at a time.
+ *
  * @param buf		Source buffer to verify against EC flash
  * @param offset	Offset in EC flash to check
  * @param size		Number of bytes to check
@@ -28,6 +31,30 @@ int ec_flash_read(uint8_t *buf, int offset, int size);
  */
 int ec_flash_verify(const uint8_t *buf, int offset, int size);
 
+/**
+ * Compare a range of EC flash against a buffer using the EC's SHA-256 hash
+ * of that range (EC_CMD_VBOOT_HASH), without reading the data back.
+ *
+ * Note that this replaces the hash the EC keeps for its RW image; call
+ * ec_flash_hash_restore() when done.
+ *
+ * @param buf		Expected contents
+ * @param offset	Offset in EC flash to check
+ * @param size		Number of bytes to check
+ *
+ * @return 1 if the hashes match, 0 if they differ, negative if the EC could
+ * not compute the hash.
+ */
+int ec_flash_hash_match(const uint8_t *buf, int offset, int size);
+
+/**
+ * Have the EC start hashing its active RW image again, to restore the hash
+ * replaced by ec_flash_hash_match().
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_hash_restore(void);
+
 /**
  * Write EC flash memory
  *
@@ -39,6 +66,20 @@ int ec_flash_verify(const uint8_t *buf, int offset, int size);
  */
 int ec_flash_write(const uint8_t *buf, int offset, int size);
 
+/**
+ * Update EC flash memory, rewriting only erase blocks that changed
+ *
+ * Each erase block is compared through its EC-side hash; mismatching blocks
+ * are erased and written. Prints the number of bytes saved and time taken.
+ *
+ * @param buf		Source buffer
+ * @param offset	Offset in EC flash to write, erase block aligned
+ * @param size		Number of bytes to write, erase block aligned
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_write_diff(const uint8_t *buf, int offset, int size);
+
 /**
  * Erase EC flash memory
  *
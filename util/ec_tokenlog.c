@@ -0,0 +1,487 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Renders the tokenized console log (CONFIG_CONSOLE_TOKENIZED_LOG) using the
+ * format strings from the EC image's ELF file.
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ec_commands.h"
+#include "ec_tokenlog.h"
+
+/* Flags for a conversion, as in common/printf.c */
+#define PF_LEFT		(1 << 0)  /* Left-justify */
+#define PF_PADZERO	(1 << 1)  /* Pad with 0's not spaces */
+#define PF_SIGN		(1 << 2)  /* Add sign (+) for a positive number */
+#define PF_64BIT	(1 << 3)  /* Number is 64-bit */
+
+/*
+ * Longest number the EC prints: 64 bits in binary, or up to 31 digits of
+ * fixed-point precision, plus sign, point and terminating null.
+ */
+#define MAX_PRECISION 31
+#define NUM_BUF_SIZE (64 + MAX_PRECISION + 3)
+
+struct elf_file {
+	const uint8_t *data;
+	size_t size;
+	int is_64;
+	uint64_t shoff;
+	int shnum;
+	int shentsize;
+};
+
+/* Format strings of the image */
+struct log_fmts {
+	const char *base;
+	uint32_t size;
+	int long_64;	/* long and size_t are 64-bit on the target */
+};
+
+/* Arguments of one record */
+struct log_args {
+	const uint8_t *p;
+	const uint8_t *end;
+	int missing;	/* Arguments ran out; the EC dropped them */
+};
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *buf = NULL;
+	long len;
+
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+
+	if (fseek(f, 0, SEEK_END) == 0 && (len = ftell(f)) > 0 &&
+	    fseek(f, 0, SEEK_SET) == 0) {
+		buf = malloc(len);
+		if (buf && fread(buf, 1, len, f) != (size_t)len) {
+			free(buf);
+			buf = NULL;
+		}
+		*size = len;
+	}
+	if (!buf)
+		fprintf(stderr, "Unable to read %s\n", path);
+
+	fclose(f);
+	return buf;
+}
+
+static int elf_get_shdr(const struct elf_file *e, int i, Elf64_Shdr *sh)
+{
+	uint64_t off = e->shoff + (uint64_t)i * e->shentsize;
+	Elf32_Shdr sh32;
+
+	if (i >= e->shnum || off + e->shentsize > e->size)
+		return -1;
+
+	if (e->is_64) {
+		memcpy(sh, e->data + off, sizeof(*sh));
+		return 0;
+	}
+
+	memcpy(&sh32, e->data + off, sizeof(sh32));
+	sh->sh_type = sh32.sh_type;
+	sh->sh_flags = sh32.sh_flags;
+	sh->sh_addr = sh32.sh_addr;
+	sh->sh_offset = sh32.sh_offset;
+	sh->sh_size = sh32.sh_size;
+	sh->sh_link = sh32.sh_link;
+	sh->sh_entsize = sh32.sh_entsize;
+	return 0;
+}
+
+static int elf_get_sym(const struct elf_file *e, const Elf64_Shdr *symtab,
+		       int i, Elf64_Sym *sym)
+{
+	Elf32_Sym sym32;
+	uint64_t off;
+
+	if (e->is_64) {
+		off = symtab->sh_offset + (uint64_t)i * sizeof(*sym);
+		if (off + sizeof(*sym) > e->size)
+			return -1;
+		memcpy(sym, e->data + off, sizeof(*sym));
+		return 0;
+	}
+
+	off = symtab->sh_offset + (uint64_t)i * sizeof(sym32);
+	if (off + sizeof(sym32) > e->size)
+		return -1;
+	memcpy(&sym32, e->data + off, sizeof(sym32));
+	sym->st_name = sym32.st_name;
+	sym->st_value = sym32.st_value;
+	return 0;
+}
+
+/* Look up the address of a symbol in the symbol tables */
+static int elf_find_symbol(const struct elf_file *e, const char *name,
+			   uint64_t *addr)
+{
+	int sym_size = e->is_64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	Elf64_Shdr symtab, strtab;
+	Elf64_Sym sym;
+	int i, j, len = strlen(name);
+
+	for (i = 0; elf_get_shdr(e, i, &symtab) == 0; i++) {
+		if (symtab.sh_type != SHT_SYMTAB ||
+		    elf_get_shdr(e, symtab.sh_link, &strtab))
+			continue;
+
+		for (j = 0; j < symtab.sh_size / sym_size; j++) {
+			uint64_t off;
+
+			if (elf_get_sym(e, &symtab, j, &sym))
+				break;
+			off = strtab.sh_offset + sym.st_name;
+			if (sym.st_name + len >= strtab.sh_size ||
+			    off + len >= e->size)
+				continue;
+			if (!memcmp(e->data + off, name, len + 1)) {
+				*addr = sym.st_value;
+				return 0;
+			}
+		}
+	}
+
+	return -1;
+}
+
+/* Find the file contents at an address in the image */
+static const uint8_t *elf_map(const struct elf_file *e, uint64_t addr,
+			      uint64_t len)
+{
+	Elf64_Shdr sh;
+	int i;
+
+	for (i = 0; elf_get_shdr(e, i, &sh) == 0; i++) {
+		if (!(sh.sh_flags & SHF_ALLOC) || sh.sh_type == SHT_NOBITS)
+			continue;
+		if (addr < sh.sh_addr || addr + len > sh.sh_addr + sh.sh_size)
+			continue;
+		if (sh.sh_offset + (addr - sh.sh_addr) + len > e->size)
+			return NULL;
+		return e->data + sh.sh_offset + (addr - sh.sh_addr);
+	}
+
+	return NULL;
+}
+
+static int load_log_fmts(const uint8_t *data, size_t size,
+			 struct log_fmts *fmts)
+{
+	const Elf32_Ehdr *eh32 = (const Elf32_Ehdr *)data;
+	const Elf64_Ehdr *eh64 = (const Elf64_Ehdr *)data;
+	struct elf_file e = { .data = data, .size = size };
+	uint64_t start, end;
+
+	if (size < sizeof(*eh64) || memcmp(data, ELFMAG, SELFMAG) ||
+	    data[EI_DATA] != ELFDATA2LSB) {
+		fprintf(stderr, "Not a little-endian ELF file\n");
+		return -1;
+	}
+
+	e.is_64 = data[EI_CLASS] == ELFCLASS64;
+	if (e.is_64) {
+		e.shoff = eh64->e_shoff;
+		e.shnum = eh64->e_shnum;
+		e.shentsize = eh64->e_shentsize;
+	} else {
+		e.shoff = eh32->e_shoff;
+		e.shnum = eh32->e_shnum;
+		e.shentsize = eh32->e_shentsize;
+	}
+
+	if (elf_find_symbol(&e, "__log_fmts", &start) ||
+	    elf_find_symbol(&e, "__log_fmts_end", &end) || end < start) {
+		fprintf(stderr, "No tokenized log format strings in image\n");
+		return -1;
+	}
+
+	fmts->size = end - start;
+	fmts->base = (const char *)elf_map(&e, start, fmts->size);
+	fmts->long_64 = e.is_64;
+	if (!fmts->base && fmts->size) {
+		fprintf(stderr, "Unable to find format strings in image\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static uint64_t get_arg(struct log_args *a, int size)
+{
+	uint64_t v = 0;
+
+	if (a->p + size > a->end) {
+		a->missing = 1;
+		a->p = a->end;
+		return 0;
+	}
+
+	memcpy(&v, a->p, size);
+	a->p += size;
+	return v;
+}
+
+static void print_padded(const char *s, int len, int pad_width, int flags)
+{
+	int pad;
+
+	for (pad = pad_width - len; pad > 0 && !(flags & PF_LEFT); pad--)
+		putchar(flags & PF_PADZERO ? '0' : ' ');
+	fwrite(s, 1, len, stdout);
+	for (; pad > 0; pad--)
+		putchar(' ');
+}
+
+/*
+ * Convert an integer the way common/printf.c does, including the
+ * fixed-point precision.  Returns the start of the string in buf.
+ */
+static char *format_number(char *buf, uint64_t v, int c, int base,
+			   int precision, int flags)
+{
+	char *s = buf + NUM_BUF_SIZE - 1;
+	char sign = 0;
+	int i;
+
+	*s = '\0';
+
+	if (c == 'd' || c == 'i') {
+		int neg = flags & PF_64BIT ? (int64_t)v < 0 : (int32_t)v < 0;
+
+		if (neg) {
+			sign = '-';
+			v = flags & PF_64BIT ? -v : (uint32_t)-(uint32_t)v;
+		} else if (flags & PF_SIGN) {
+			sign = '+';
+		}
+	}
+
+	if (precision > MAX_PRECISION)
+		precision = MAX_PRECISION;
+	for (i = 0; i < precision; i++) {
+		*(--s) = '0' + v % 10;
+		v /= 10;
+	}
+	if (precision >= 0)
+		*(--s) = '.';
+
+	if (!v)
+		*(--s) = '0';
+	while (v) {
+		int digit = v % base;
+
+		v /= base;
+		if (digit < 10)
+			*(--s) = '0' + digit;
+		else
+			*(--s) = (c == 'X' ? 'A' : 'a') + digit - 10;
+	}
+
+	if (sign)
+		*(--s) = sign;
+
+	return s;
+}
+
+/* Print one record's format string with its arguments */
+static void print_record(const char *format, struct log_args *a, int long_64)
+{
+	char buf[NUM_BUF_SIZE];
+
+	while (*format) {
+		int c = *format++;
+		int flags = 0, pad_width = 0, precision = -1;
+		int base = 10, len;
+		uint64_t v;
+		const char *s;
+
+		if (c != '%') {
+			putchar(c);
+			continue;
+		}
+
+		c = *format++;
+		if (c == '%' || c == '\0') {
+			putchar('%');
+			if (c == '\0')
+				break;
+			continue;
+		}
+		if (c == 'c') {
+			v = get_arg(a, 4);
+			if (!a->missing)
+				putchar((int)v);
+			continue;
+		}
+
+		if (c == '-') {
+			flags |= PF_LEFT;
+			c = *format++;
+		}
+		if (c == '+') {
+			flags |= PF_SIGN;
+			c = *format++;
+		}
+		if (c == '0') {
+			flags |= PF_PADZERO;
+			c = *format++;
+		}
+		if (c == '*') {
+			pad_width = (int32_t)get_arg(a, 4);
+			c = *format++;
+		} else {
+			while (c >= '0' && c <= '9') {
+				pad_width = 10 * pad_width + c - '0';
+				c = *format++;
+			}
+		}
+		if (c == '.') {
+			c = *format++;
+			if (c == '*') {
+				precision = (int32_t)get_arg(a, 4);
+				c = *format++;
+			} else {
+				precision = 0;
+				while (c >= '0' && c <= '9') {
+					precision = 10 * precision + c - '0';
+					c = *format++;
+				}
+			}
+		}
+		if (pad_width < 0 || precision < -1) {
+			printf("ERROR");
+			return;
+		}
+
+		if (c == 'l') {
+			if (long_64)
+				flags |= PF_64BIT;
+			c = *format++;
+			if (c == 'l') {
+				flags |= PF_64BIT;
+				c = *format++;
+			}
+			if (!(flags & PF_64BIT)) {
+				printf("ERROR");
+				return;
+			}
+		} else if (c == 'z') {
+			if (long_64)
+				flags |= PF_64BIT;
+			c = *format++;
+		}
+
+		if (c == 's') {
+			s = (const char *)a->p;
+			len = strnlen(s, a->end - a->p);
+			a->p += len < a->end - a->p ? len + 1 : len;
+			if (precision >= 0 && len > precision)
+				len = precision;
+			if (precision >= 0 && pad_width > precision)
+				pad_width = precision;
+			print_padded(s, len, pad_width, flags);
+			continue;
+		}
+
+		if (c == 'p') {
+			c = *format++;
+			if (c == 'h') {
+				len = get_arg(a, 1);
+				while (len-- > 0)
+					printf("%02x", (int)get_arg(a, 1));
+				continue;
+			} else if (c == 'T') {
+				v = get_arg(a, 8);
+				flags |= PF_64BIT;
+				precision = 6;
+				c = 'u';
+			} else if (c == 'P') {
+				v = get_arg(a, 4);
+				base = 16;
+				c = 'x';
+			} else if (c == 'b') {
+				v = get_arg(a, 4);
+				pad_width = get_arg(a, 1);
+				flags |= PF_PADZERO;
+				base = 2;
+				c = 'b';
+				precision = -1;
+			} else {
+				printf("ERROR");
+				return;
+			}
+		} else if (c == 'd' || c == 'i' || c == 'u') {
+			v = get_arg(a, flags & PF_64BIT ? 8 : 4);
+		} else if (c == 'x' || c == 'X') {
+			v = get_arg(a, flags & PF_64BIT ? 8 : 4);
+			base = 16;
+		} else if (c == 'b') {
+			v = get_arg(a, flags & PF_64BIT ? 8 : 4);
+			base = 2;
+		} else {
+			printf("ERROR");
+			return;
+		}
+
+		s = format_number(buf, v, c, base, precision, flags);
+		print_padded(s, strlen(s), pad_width, flags);
+	}
+}
+
+int parse_tokenized_log(const char *elf_path, const uint8_t *log, int size)
+{
+	struct ec_console_token_record r;
+	struct log_fmts fmts;
+	struct log_args args;
+	uint8_t *elf;
+	size_t elf_size;
+	int rv;
+
+	elf = read_file(elf_path, &elf_size);
+	if (!elf)
+		return -1;
+
+	rv = load_log_fmts(elf, elf_size, &fmts);
+	while (!rv && size >= (int)sizeof(r)) {
+		memcpy(&r, log, sizeof(r));
+		if (r.size < sizeof(r) || r.size > size) {
+			fprintf(stderr, "Bad record size %d\n", r.size);
+			rv = -1;
+			break;
+		}
+
+		args.p = log + sizeof(r);
+		args.end = log + r.size;
+		args.missing = 0;
+
+		printf("[%u.%03u ", r.time_ms / 1000, r.time_ms % 1000);
+		if (r.fmt < fmts.size &&
+		    memchr(fmts.base + r.fmt, '\0', fmts.size - r.fmt))
+			print_record(fmts.base + r.fmt, &args, fmts.long_64);
+		else
+			printf("<unknown format 0x%04x>", r.fmt);
+		if (args.missing)
+			printf(" <truncated>");
+		printf("]\n");
+
+		log += r.size;
+		size -= r.size;
+	}
+
+	free(elf);
+	return rv;
+}
@@ -0,0 +1,22 @@
+/* Copyright 2026 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef EC_TOKENLOG_H
+#define EC_TOKENLOG_H
+
+#include <stdint.h>
+
+/**
+ * Prints tokenized log records to stdout, like cprints() would have.
+ *
+ * @param elf_path  ELF file of the EC image which wrote the records, for
+ *                  the format strings
+ * @param log       Records, as returned by CONSOLE_READ_TOKENS
+ * @param size      Size of the records in bytes
+ * @return 0 if success or non-zero error code if error.
+ */
+int parse_tokenized_log(const char *elf_path, const uint8_t *log, int size);
+
+#endif /* EC_TOKENLOG_H */
@@ -23,6 +23,7 @@
 #include "cros_ec_dev.h"
 #include "ec_panicinfo.h"
 #include "ec_flash.h"
+#include "ec_tokenlog.h"
 #include "ec_version.h"
 #include "ectool.h"
 #include "i2c.h"
@@ -98,6 +99,8 @@ const char help_str[] =
 	"      Prints supported version mask for a command number\n"
 	"  console\n"
 	"      Prints the last output to the EC debug console\n"
+	"  consoletokens <ec.elf>\n"
+	"      Prints the EC tokenized log, using the image's format strings\n"
 	"  cec\n"
 	"      Read or write CEC messages and settings\n"
 	"  echash [CMDS]\n"
@@ -140,8 +143,12 @@ const char help_str[] =
 	"      Prints or sets EC flash protection state\n"
 	"  flashread <offset> <size> <outfile>\n"
 	"      Reads from EC flash to a file\n"
+	"  flashverify <offset> <infile>\n"
+	"      Verifies EC flash against a file\n"
 	"  flashwrite <offset> <infile>\n"
 	"      Writes to EC flash from a file\n"
+	"  flashwritediff <offset> <infile>\n"
+	"      Writes only the EC flash erase blocks that differ from a file\n"
 	"  forcelidopen <enable>\n"
 	"      Forces the lid switch to open position\n"
 	"  fpcontext\n"
@@ -166,6 +173,8 @@ const char help_str[] =
 	"      Set the value of GPIO signal\n"
 	"  hangdetect <flags> <event_msec> <reboot_msec> | stop | start\n"
 	"      Configure or start/stop the hang detect timer\n"
+	"  hcstats [reset]\n"
+	"      Prints or resets host command latency statistics\n"
 	"  hello\n"
 	"      Checks for basic communication with EC\n"
 	"  hibdelay [sec]\n"
@@ -507,6 +516,50 @@ out:
 	return rv;
 }
 
+int cmd_hcstats(int argc, char *argv[])
+{
+	struct ec_params_hostcmd_stats p;
+	struct ec_response_hostcmd_stats r;
+	int rv, b;
+
+	memset(&p, 0, sizeof(p));
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		/* Index past any entry: reset without reading */
+		p.index = 0xff;
+		p.flags = EC_HOSTCMD_STATS_RESET;
+		rv = ec_command(EC_CMD_HOSTCMD_STATS, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		return rv < 0 ? rv : 0;
+	}
+
+	printf("cmd         count       min       avg       max (us)\n");
+	do {
+		rv = ec_command(EC_CMD_HOSTCMD_STATS, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+		if (p.index >= r.num_entries)
+			break;
+
+		printf("0x%04x %10u %9u %9u %9u\n", r.command, r.count,
+		       r.min_us, r.avg_us, r.max_us);
+		/* Non-empty buckets, labelled with their lower bound in us */
+		printf("      ");
+		for (b = 0; b < EC_HOSTCMD_STATS_BUCKETS; b++)
+			if (r.histogram[b])
+				printf(" %u:%u", b ? 1U << b : 0,
+				       r.histogram[b]);
+		printf("\n");
+	} while (++p.index < r.num_entries);
+
+	return 0;
+}
+
 int cmd_hello(int argc, char *argv[])
 {
 	struct ec_params_hello p;
@@ -1427,7 +1480,45 @@ int cmd_flash_write(int argc, char *argv[])
 	printf("Writing to offset %d...\n", offset);
 
 	/* Write data in chunks */
-	rv = ec_flash_write(buf, offset, size);
+	if (strcmp(argv[0], "flashwritediff") == 0)
+		rv = ec_flash_write_diff(buf, offset, size);
+	else
+		rv = ec_flash_write(buf, offset, size);
+
+	free(buf);
+
+	if (rv < 0)
+		return rv;
+
+	printf("done.\n");
+	return 0;
+}
+
+int cmd_flash_verify(int argc, char *argv[])
+{
+	int offset, size;
+	int rv;
+	char *e;
+	char *buf;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <offset> <filename>\n", argv[0]);
+		return -1;
+	}
+
+	offset = strtol(argv[1], &e, 0);
+	if ((e && *e) || offset < 0 || offset > MAX_FLASH_SIZE) {
+		fprintf(stderr, "Bad offset.\n");
+		return -1;
+	}
+
+	buf = read_file(argv[2], &size);
+	if (!buf)
+		return -1;
+
+	printf("Verifying %d bytes at offset %d...\n", size, offset);
+
+	rv = ec_flash_verify((const uint8_t *)buf, offset, size);
 
 	free(buf);
 
@@ -1600,14 +1691,18 @@ int cmd_rw_hash_pd(int argc, char *argv[])
 int cmd_rwsig_status(int argc, char *argv[])
 {
 	int rv;
-	struct ec_response_rwsig_check_status resp;
+	struct ec_response_rwsig_check_status_v1 resp;
+	int cmdver = ec_cmd_version_supported(EC_CMD_RWSIG_CHECK_STATUS, 1) ?
+		1 : 0;
 
-	rv = ec_command(EC_CMD_RWSIG_CHECK_STATUS, 0, NULL, 0,
+	rv = ec_command(EC_CMD_RWSIG_CHECK_STATUS, cmdver, NULL, 0,
 			&resp, sizeof(resp));
 	if (rv < 0)
 		return rv;
 
 	printf("RW signature check: %s\n", resp.status ? "OK" : "FAILED");
+	if (cmdver >= 1)
+		printf("RW verify time: %u us\n", resp.verify_time_us);
 
 	return 0;
 }
@@ -3012,18 +3107,35 @@ int cmd_temp_sensor_info(int argc, char *argv[])
 	}
 
 	if (strcmp(argv[1], "all") == 0) {
-		for (p.id = 0;
-		     p.id < EC_TEMP_SENSOR_ENTRIES + EC_TEMP_SENSOR_B_ENTRIES;
-		     p.id++) {
-			if (read_mapped_temperature(p.id) ==
+		struct ec_params_temp_sensor_get_info
+			ps[EC_TEMP_SENSOR_ENTRIES + EC_TEMP_SENSOR_B_ENTRIES];
+		struct ec_response_temp_sensor_get_info rs[ARRAY_SIZE(ps)];
+		struct ec_batch_cmd cmds[ARRAY_SIZE(ps)];
+		int i, n = 0;
+
+		/* Ask about all the sensors present at once */
+		for (i = 0; i < ARRAY_SIZE(ps); i++) {
+			if (read_mapped_temperature(i) ==
 			    EC_TEMP_SENSOR_NOT_PRESENT)
 				continue;
-			rv = ec_command(EC_CMD_TEMP_SENSOR_GET_INFO, 0,
-					&p, sizeof(p), &r, sizeof(r));
-			if (rv < 0)
+			ps[n].id = i;
+			cmds[n] = (struct ec_batch_cmd){
+				.command = EC_CMD_TEMP_SENSOR_GET_INFO,
+				.outdata = &ps[n], .outsize = sizeof(ps[n]),
+				.indata = &rs[n], .insize = sizeof(rs[n]),
+			};
+			n++;
+		}
+
+		rv = ec_command_batch(cmds, n);
+		if (rv < 0)
+			return rv;
+
+		for (i = 0; i < n; i++) {
+			if (cmds[i].rv < 0)
 				continue;
-			printf("%d: %d %s\n", p.id, r.sensor_type,
-			       r.sensor_name);
+			printf("%d: %d %s\n", ps[i].id, rs[i].sensor_type,
+			       rs[i].sensor_name);
 		}
 		return 0;
 	}
@@ -8499,6 +8611,50 @@ int cmd_console(int argc, char *argv[])
 	printf("\n");
 	return 0;
 }
+
+int cmd_console_tokens(int argc, char *argv[])
+{
+	struct ec_params_console_read_v1 p = {
+		.subcmd = CONSOLE_READ_TOKENS,
+	};
+	uint8_t *log = NULL, *grown;
+	int size = 0;
+	int rv;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <ec.elf>\n", argv[0]);
+		return -1;
+	}
+
+	/* Snapshot the EC console */
+	rv = ec_command(EC_CMD_CONSOLE_SNAPSHOT, 0, NULL, 0, NULL, 0);
+	if (rv < 0)
+		return rv;
+
+	/* Read whole records from the snapshot until it's done */
+	while (1) {
+		rv = ec_command(EC_CMD_CONSOLE_READ, 1, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv <= 0)
+			break;
+
+		grown = realloc(log, size + rv);
+		if (!grown) {
+			rv = -1;
+			break;
+		}
+		log = grown;
+		memcpy(log + size, ec_inbuf, rv);
+		size += rv;
+	}
+
+	if (rv == 0)
+		rv = parse_tokenized_log(argv[1], log, size);
+
+	free(log);
+	return rv;
+}
+
 struct param_info {
 	const char *name;	/* name of this parameter */
 	const char *help;	/* help message */
@@ -10044,6 +10200,7 @@ const struct command commands[] = {
 	{"chipinfo", cmd_chipinfo},
 	{"cmdversions", cmd_cmdversions},
 	{"console", cmd_console},
+	{"consoletokens", cmd_console_tokens},
 	{"cec", cmd_cec},
 	{"echash", cmd_ec_hash},
 	{"eventclear", cmd_host_event_clear},
@@ -10062,7 +10219,9 @@ const struct command commands[] = {
 	{"flasheraseasync", cmd_flash_erase},
 	{"flashprotect", cmd_flash_protect},
 	{"flashread", cmd_flash_read},
+	{"flashverify", cmd_flash_verify},
 	{"flashwrite", cmd_flash_write},
+	{"flashwritediff", cmd_flash_write},
 	{"flashinfo", cmd_flash_info},
 	{"flashspiinfo", cmd_flash_spi_info},
 	{"flashpd", cmd_flash_pd},
@@ -10078,6 +10237,7 @@ const struct command commands[] = {
 	{"gpioget", cmd_gpio_get},
 	{"gpioset", cmd_gpio_set},
 	{"hangdetect", cmd_hang_detect},
+	{"hcstats", cmd_hcstats},
 	{"hello", cmd_hello},
 	{"hibdelay", cmd_hibdelay},
 	{"hostevent", cmd_hostevent},
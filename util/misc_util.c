@@ -173,3 +173,22 @@ int kernel_version_ge(int major, int minor, int sublevel)
 	return ksublevel >= sublevel;
 }
 
+
+#if defined(CONFIG_DEBUG_ASSERT) && defined(CONFIG_DEBUG_ASSERT_REBOOTS)
+/* ASSERT() handler for EC sources (e.g. common/sha256.c) linked into tools */
+#ifdef CONFIG_DEBUG_ASSERT_BRIEF
+void panic_assert_fail(const char *fname, int linenum)
+{
+	fprintf(stderr, "ASSERTION FAILURE in %s:%d\n", fname, linenum);
+	abort();
+}
+#else
+void panic_assert_fail(const char *msg, const char *func, const char *fname,
+		       int linenum)
+{
+	fprintf(stderr, "ASSERTION FAILURE '%s' in %s() at %s:%d\n",
+		msg, func, fname, linenum);
+	abort();
+}
+#endif
+#endif